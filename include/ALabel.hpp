@@ -2,9 +2,14 @@
 
 #include <glibmm/markup.h>
 #include <gtkmm/label.h>
+#include <gtkmm/tooltip.h>
 #include <json/json.h>
 
+#include <functional>
+#include <set>
+
 #include "AModule.hpp"
+#include "util/format_template.hpp"
 
 namespace waybar {
 
@@ -13,7 +18,7 @@ class ALabel : public AModule {
   ALabel(const Json::Value &, const std::string &, const std::string &, const std::string &format,
          uint16_t interval = 0, bool ellipsize = false, bool enable_click = false,
          bool enable_scroll = false);
-  virtual ~ALabel() = default;
+  virtual ~ALabel();
   auto update() -> void override;
   virtual std::string getIcon(uint16_t, const std::string &alt = "", uint16_t max = 0);
   virtual std::string getIcon(uint16_t, const std::vector<std::string> &alts, uint16_t max = 0);
@@ -24,9 +29,46 @@ class ALabel : public AModule {
   const std::chrono::seconds interval_;
   bool alt_ = false;
   std::string default_format_;
+  // Compiled format and tooltip-format templates
+  util::FormatCache formats_;
 
   bool handleToggle(GdkEventButton *const &e) override;
   virtual std::string getState(uint8_t value, bool lesser = false);
+
+  // Update the label, nothing is done if the value is the same as the last time
+  void setMarkup(const std::string &markup);
+  void setTooltipText(const std::string &text);
+  void setTooltipMarkup(const std::string &markup);
+  void setClass(const std::string &name, bool enabled);
+  /* Whether `name` was enabled with setClass */
+  bool hasClass(const std::string &name) const { return classes_.count(name) > 0; }
+  /**
+   * Lazy tooltip: `render` is called when GTK is about to show the tooltip instead of building it
+   * on every update, as it is only visible while hovered. The result is kept until the renderer is
+   * replaced, so call this again when the data shown changed. Calling setTooltipText or
+   * setTooltipMarkup drops the renderer.
+   */
+  void setTooltipRenderer(std::function<std::string()> render, bool markup = false);
+
+ private:
+  bool handleQueryTooltip(int x, int y, bool keyboard, const Glib::RefPtr<Gtk::Tooltip> &tooltip);
+
+  // Labels are truncated here rather than ellipsized by Pango on each layout, 0 if unlimited
+  size_t max_length_ = 0;
+  std::string markup_;
+  std::string tooltip_;
+  bool tooltip_markup_ = false;
+  std::function<std::string()> tooltip_render_;
+  bool tooltip_render_markup_ = false;
+  // Bumped by each setTooltipRenderer, the cached tooltip is the one of tooltip_rendered_
+  uint64_t tooltip_version_ = 0;
+  uint64_t tooltip_rendered_ = 0;
+  std::string tooltip_cache_;
+  sigc::connection query_tooltip_conn_;
+  sigc::connection tooltip_refresh_conn_;
+  bool hovered_ = false;
+  // Classes set through setClass
+  std::set<std::string, std::less<>> classes_;
 };
 
 }  // namespace waybar
@@ -29,6 +29,19 @@ class AModule : public IModule {
 
   SCROLL_DIR getScrollDir(GdkEventScroll *e);
   bool tooltipEnabled();
+  /**
+   * Dirty checking of widget updates: returns whether `value` differs from `last`, the value
+   * applied by the previous update, and stores it. Setting markup or a tooltip makes GTK lay out
+   * the text again and commit a new frame even if it did not change, most updates of a module
+   * running on an interval don't.
+   */
+  bool changed(std::string &last, const std::string &value);
+
+  // Widget updates requested by the module, and skipped because nothing changed
+  struct RenderStats {
+    uint64_t requested = 0;
+    uint64_t skipped = 0;
+  } render_stats_;
 
   const std::string name_;
   const Json::Value &config_;
@@ -9,14 +9,27 @@
 #if defined(__linux__)
 #include <sys/inotify.h>
 #endif
+#if defined(__linux__) && defined(HAVE_LIBUDEV)
+#include <glibmm/iochannel.h>
+#endif
 
 #include <algorithm>
 #include <fstream>
+#include <memory>
 #include <string>
 #include <vector>
 
 #include "ALabel.hpp"
+#include "util/scheduler.hpp"
 #include "util/sleeper_thread.hpp"
+#if defined(__linux__)
+#include "util/sysfs.hpp"
+#endif
+
+#if defined(__linux__) && defined(HAVE_LIBUDEV)
+struct udev;
+struct udev_monitor;
+#endif
 
 namespace waybar::modules {
 
@@ -35,24 +48,43 @@ class Battery : public ALabel {
  private:
   static inline const fs::path data_dir_ = "/sys/class/power_supply/";
 
+#if defined(__linux__)
+  struct BatteryNode {
+    int watch;
+    std::unique_ptr<util::SysfsDevice> attributes;
+  };
+#endif
+
   void refreshBatteries();
   void worker();
-  const std::string getAdapterStatus(uint8_t capacity) const;
+  const std::string getAdapterStatus(uint8_t capacity);
   const std::tuple<uint8_t, float, std::string, float> getInfos();
   const std::string formatTimeRemaining(float hoursRemaining);
+#if defined(__linux__) && defined(HAVE_LIBUDEV)
+  bool startUdevMonitor();
+  bool handleUdevEvent(Glib::IOCondition cond);
+#endif
 
-  int global_watch;
-  std::map<fs::path, int> batteries_;
-  fs::path adapter_;
-  int battery_watch_fd_;
-  int global_watch_fd_;
+  int global_watch{-1};
+#if defined(__linux__)
+  std::map<fs::path, BatteryNode> batteries_;
+  std::unique_ptr<util::SysfsDevice> adapter_;
+#endif
+  // Both stay at -1 when changes are reported by udev
+  int battery_watch_fd_{-1};
+  int global_watch_fd_{-1};
+#if defined(__linux__) && defined(HAVE_LIBUDEV)
+  udev* udev_{nullptr};
+  udev_monitor* udev_monitor_{nullptr};
+  sigc::connection udev_conn_;
+#endif
   std::mutex battery_list_mutex_;
   std::string old_status_;
   bool warnFirstTime_{true};
 
   util::SleeperThread thread_;
   util::SleeperThread thread_battery_update_;
-  util::SleeperThread thread_timer_;
+  util::Timer timer_;
 };
 
 }  // namespace waybar::modules
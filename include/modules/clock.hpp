@@ -2,7 +2,7 @@
 
 #include "ALabel.hpp"
 #include "util/date.hpp"
-#include "util/sleeper_thread.hpp"
+#include "util/scheduler.hpp"
 
 namespace waybar::modules {
 
@@ -28,7 +28,7 @@ class Clock final : public ALabel {
   auto doAction(const std::string& name) -> void override;
 
  private:
-  util::SleeperThread thread_;
+  util::Timer timer_;
   std::locale locale_;
   std::vector<const date::time_zone*> time_zones_;
   int current_time_zone_idx_;
@@ -47,12 +47,11 @@ class Clock final : public ALabel {
   uint cldMonCols_{3};    // Count of the month in the row
   int cldMonColLen_{20};  // Length of the month column
   int cldWnLen_{3};       // Length of the week number
-  date::year_month_day cldYearShift_;
-  date::year_month cldMonShift_;
   date::months cldCurrShift_{0};
   date::months cldShift_{0};
-  std::string cldYearCached_{};
-  std::string cldMonCached_{};
+  // Rendered calendars by mode and month (January in year mode), all built on cldCacheDay_
+  std::map<std::pair<CldMode, date::year_month>, std::string> cldCache_;
+  date::year_month_day cldCacheDay_;
   /*Calendar functions*/
   auto get_calendar(const date::zoned_seconds& now, const date::zoned_seconds& wtime)
       -> std::string;
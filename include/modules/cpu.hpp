@@ -1,6 +1,8 @@
 #pragma once
 
 #include <fmt/format.h>
+#include <gtkmm/box.h>
+#include <gtkmm/drawingarea.h>
 
 #include <cstdint>
 #include <fstream>
@@ -10,26 +12,48 @@
 #include <vector>
 
 #include "ALabel.hpp"
-#include "util/sleeper_thread.hpp"
+#include "util/ring_buffer.hpp"
+#include "util/sampler.hpp"
 
 namespace waybar::modules {
 
 class Cpu : public ALabel {
  public:
   Cpu(const std::string&, const Json::Value&);
-  virtual ~Cpu() = default;
+  virtual ~Cpu();
   auto update() -> void override;
 
  private:
-  double getCpuLoad();
-  std::tuple<std::vector<uint16_t>, std::string> getCpuUsage();
-  std::tuple<float, float, float> getCpuFrequency();
-  std::vector<std::tuple<size_t, size_t>> parseCpuinfo();
-  std::vector<float> parseCpuFrequencies();
-
-  std::vector<std::tuple<size_t, size_t>> prev_times_;
-
-  util::SleeperThread thread_;
+  // Data shared by all the cpu modules with the same interval
+  struct Sample {
+    double load;
+    std::vector<uint16_t> usage;
+    float max_frequency;
+    float min_frequency;
+    float avg_frequency;
+  };
+
+  static double getCpuLoad();
+  static std::vector<uint16_t> getCpuUsage(std::vector<std::tuple<size_t, size_t>>& prev_times,
+                                           std::vector<std::tuple<size_t, size_t>>& curr_times);
+  static std::tuple<float, float, float> getCpuFrequency();
+  // Fills (idle, total) times for the whole system followed by each core, reusing the storage
+  static void parseCpuinfo(std::vector<std::tuple<size_t, size_t>>& cpuinfo);
+  static std::vector<float> parseCpuFrequencies();
+
+  void pushHistory(const std::vector<uint16_t>& usage);
+  bool handleGraphDraw(const Cairo::RefPtr<Cairo::Context>& cr);
+
+  std::shared_ptr<util::Sampler<Sample>> sampler_;
+  sigc::connection sampler_conn_;
+  util::Sampler<Sample>::sample_ptr last_sample_;
+
+  // Usage history of the whole system followed by each core
+  util::RingBuffer<uint8_t> history_;
+  // Sparkline of each history series, updated one glyph at a time
+  std::vector<std::string> sparklines_;
+  Gtk::Box box_;
+  Gtk::DrawingArea graph_;
 };
 
 }  // namespace waybar::modules
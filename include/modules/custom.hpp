@@ -34,6 +34,8 @@ class Custom : public ALabel {
   std::string alt_;
   std::string tooltip_;
   std::vector<std::string> class_;
+  // Classes of the output currently set on the label
+  std::vector<std::string> applied_class_;
   int percentage_;
   FILE* fp_;
   int pid_;
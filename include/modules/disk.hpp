@@ -4,22 +4,26 @@
 #include <sys/statvfs.h>
 
 #include <fstream>
+#include <optional>
 
 #include "ALabel.hpp"
 #include "util/format.hpp"
-#include "util/sleeper_thread.hpp"
+#include "util/sampler.hpp"
 
 namespace waybar::modules {
 
 class Disk : public ALabel {
  public:
   Disk(const std::string&, const Json::Value&);
-  virtual ~Disk() = default;
+  virtual ~Disk();
   auto update() -> void override;
 
  private:
-  util::SleeperThread thread_;
+  using sample_t = std::optional<struct statvfs>;
+
   std::string path_;
+  std::shared_ptr<util::Sampler<sample_t>> sampler_;
+  sigc::connection sampler_conn_;
 };
 
 }  // namespace waybar::modules
@@ -6,6 +6,7 @@
 #include "bar.hpp"
 #include "modules/hyprland/backend.hpp"
 #include "util/json.hpp"
+#include "util/rewrite_title.hpp"
 
 namespace waybar::modules::hyprland {
 
@@ -25,6 +26,7 @@ class Window : public waybar::ALabel, public EventHandler {
   std::mutex mutex_;
   const Bar& bar_;
   util::JsonParser parser_;
+  util::RewriteRules rewrite_rules_;
   std::string lastView;
 };
 
@@ -9,8 +9,9 @@
 #include "ALabel.hpp"
 #include "gtkmm/box.h"
 #include "util/command.hpp"
+#include "util/icon_loader.hpp"
 #include "util/json.hpp"
-#include "util/sleeper_thread.hpp"
+#include "util/scheduler.hpp"
 
 namespace waybar::modules {
 
@@ -31,7 +32,8 @@ class Image : public AModule {
   int size_;
   int interval_;
 
-  util::SleeperThread thread_;
+  util::Timer timer_;
+  util::IconRequest request_;
 };
 
 }  // namespace waybar::modules
@@ -2,26 +2,54 @@
 
 #include <fmt/format.h>
 
+#include <array>
+#include <bitset>
 #include <fstream>
-#include <unordered_map>
 
 #include "ALabel.hpp"
-#include "util/sleeper_thread.hpp"
+#include "util/sampler.hpp"
 
 namespace waybar::modules {
 
 class Memory : public ALabel {
  public:
   Memory(const std::string&, const Json::Value&);
-  virtual ~Memory() = default;
+  virtual ~Memory();
   auto update() -> void override;
 
- private:
-  void parseMeminfo();
-
-  std::unordered_map<std::string, unsigned long> meminfo_;
+  /* Fields of /proc/meminfo used by the module, plus the size of the ZFS ARC */
+  enum Field {
+    MemTotal,
+    MemFree,
+    MemAvailable,
+    Buffers,
+    Cached,
+    SReclaimable,
+    Shmem,
+    SwapTotal,
+    SwapFree,
+    ZfsSize,
+    FieldCount
+  };
 
-  util::SleeperThread thread_;
+ private:
+  /* Values in kB, fields missing on this system are zero */
+  struct meminfo_t {
+    std::array<unsigned long, FieldCount> values{};
+    std::bitset<FieldCount> present;
+
+    unsigned long operator[](Field field) const { return values[field]; }
+    void set(Field field, unsigned long value) {
+      values[field] = value;
+      present.set(field);
+    }
+  };
+
+  /* Swap fields are only read when `swap` is set */
+  static meminfo_t parseMeminfo(bool swap);
+
+  std::shared_ptr<util::Sampler<meminfo_t>> sampler_;
+  sigc::connection sampler_conn_;
 };
 
 }  // namespace waybar::modules
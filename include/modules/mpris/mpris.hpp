@@ -12,7 +12,7 @@ extern "C" {
 }
 
 #include "ALabel.hpp"
-#include "util/sleeper_thread.hpp"
+#include "util/scheduler.hpp"
 
 namespace waybar::modules::mpris {
 
@@ -79,7 +79,7 @@ class Mpris : public ALabel {
   std::string lastStatus;
   std::string lastPlayer;
 
-  util::SleeperThread thread_;
+  util::Timer timer_;
 };
 
 }  // namespace waybar::modules::mpris
@@ -8,9 +8,11 @@
 #include <netlink/netlink.h>
 #include <sys/epoll.h>
 
+#include <array>
 #include <optional>
 
 #include "ALabel.hpp"
+#include "util/scheduler.hpp"
 #include "util/sleeper_thread.hpp"
 #ifdef WANT_RFKILL
 #include "util/rfkill.hpp"
@@ -36,6 +38,7 @@ class Network : public ALabel {
 
   void worker();
   void createInfoSocket();
+  void createStatsSocket();
   void createEventSocket();
   void parseEssid(struct nlattr**);
   void parseSignal(struct nlattr**);
@@ -55,6 +58,10 @@ class Network : public ALabel {
   struct nl_sock* ev_sock_ = nullptr;
   int efd_;
   int ev_fd_;
+  // rtnetlink socket used to query the counters of the interface
+  int stats_fd_ = -1;
+  uint32_t stats_seq_ = 0;
+  std::array<char, 16384> stats_buffer_;
   int nl80211_id_;
   std::mutex mutex_;
 
@@ -81,7 +88,8 @@ class Network : public ALabel {
   uint32_t route_priority;
 
   util::SleeperThread thread_;
-  util::SleeperThread thread_timer_;
+  util::SleeperThread thread_info_;
+  util::Timer timer_;
 #ifdef WANT_RFKILL
   util::Rfkill rfkill_;
 #endif
@@ -11,10 +11,12 @@
 #include <libdbusmenu-gtk/dbusmenu-gtk.h>
 #include <sigc++/trackable.h>
 
+#include <functional>
 #include <set>
 #include <string_view>
 
 #include "bar.hpp"
+#include "util/icon_loader.hpp"
 
 namespace waybar::modules::SNI {
 
@@ -69,8 +71,10 @@ class Item : public sigc::trackable {
 
   void updateImage();
   Glib::RefPtr<Gdk::Pixbuf> extractPixBuf(GVariant* variant);
-  Glib::RefPtr<Gdk::Pixbuf> getIconPixbuf();
-  Glib::RefPtr<Gdk::Pixbuf> getIconByName(const std::string& name, int size);
+  /* Decoding function of the current icon, run on an IconLoader worker */
+  std::function<Glib::RefPtr<Gdk::Pixbuf>()> getIconDecoder();
+  /* Decoding function of a theme icon, empty if there is no such icon */
+  std::function<Glib::RefPtr<Gdk::Pixbuf>()> getIconByName(const std::string& name, int size);
   double getScaledIconSize();
   static void onMenuDestroyed(Item* self, GObject* old_menu_pointer);
   void makeMenu();
@@ -87,6 +91,7 @@ class Item : public sigc::trackable {
   Glib::RefPtr<Gio::DBus::Proxy> proxy_;
   Glib::RefPtr<Gio::Cancellable> cancellable_;
   std::set<std::string_view> update_pending_;
+  util::IconRequest icon_request_;
 };
 
 }  // namespace waybar::modules::SNI
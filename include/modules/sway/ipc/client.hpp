@@ -1,52 +1,66 @@
 #pragma once
 
+#include <json/json.h>
 #include <sigc++/sigc++.h>
-#include <sys/socket.h>
-#include <sys/un.h>
-#include <unistd.h>
 
-#include <cstring>
-#include <memory>
+#include <cstdint>
 #include <mutex>
+#include <optional>
+#include <set>
 #include <string>
 
 #include "ipc.hpp"
-#include "util/sleeper_thread.hpp"
 
 namespace waybar::modules::sway {
 
+/* Members of the GET_TREE nodes no module reads, left out when parsing, see util::JsonParser */
+inline const std::set<std::string, std::less<>> TREE_UNUSED_MEMBERS = {
+    "rect", "window_rect", "deco_rect", "geometry", "marks", "focus", "idle_inhibitors"};
+
+/**
+ * Connection of a module to sway.
+ *
+ * All the instances share a single process-wide pair of sockets: one for the commands, on which
+ * requests from several modules may be in flight at once, and one for the events, read by a
+ * single thread that passes each event to the instances subscribed to it.
+ */
 class Ipc {
  public:
   Ipc();
   ~Ipc();
+  Ipc(const Ipc &) = delete;
+  Ipc &operator=(const Ipc &) = delete;
 
   struct ipc_response {
     uint32_t size;
     uint32_t type;
     std::string payload;
+
+    /* Payload parsed on first use, events are parsed once for all their subscribers */
+    const Json::Value &json() const;
+
+    mutable std::optional<Json::Value> parsed = std::nullopt;
   };
 
+  /* Emitted on the event thread, handlers must not call subscribe() */
   sigc::signal<void, const struct ipc_response &> signal_event;
+  /* Emitted on the thread calling sendCmd() */
   sigc::signal<void, const struct ipc_response &> signal_cmd;
 
   void sendCmd(uint32_t type, const std::string &payload = "");
+  /**
+   * Start receiving the events of a JSON array of event names on signal_event.
+   * Connect the handlers first, events may arrive before this returns.
+   */
   void subscribe(const std::string &payload);
-  void handleEvent();
-  void setWorker(std::function<void()> &&func);
-
- protected:
-  static inline const std::string ipc_magic_ = "i3-ipc";
-  static inline const size_t ipc_header_size_ = ipc_magic_.size() + 8;
 
-  const std::string getSocketPath() const;
-  int open(const std::string &) const;
-  struct ipc_response send(int fd, uint32_t type, const std::string &payload = "");
-  struct ipc_response recv(int fd);
+ private:
+  friend class IpcHub;
 
-  int fd_;
-  int fd_event_;
+  // Serializes the commands of this instance and their signal_cmd handlers
   std::mutex mutex_;
-  util::SleeperThread thread_;
+  // Mask of the subscribed events, see event_mask()
+  uint32_t events_ = 0;
 };
 
 }  // namespace waybar::modules::sway
@@ -6,7 +6,6 @@
 #include "bar.hpp"
 #include "client.hpp"
 #include "modules/sway/ipc/client.hpp"
-#include "util/json.hpp"
 
 namespace waybar::modules::sway {
 
@@ -20,7 +19,6 @@ class Mode : public ALabel, public sigc::trackable {
   void onEvent(const struct Ipc::ipc_response&);
 
   std::string mode_;
-  util::JsonParser parser_;
   std::mutex mutex_;
   Ipc ipc_;
 };
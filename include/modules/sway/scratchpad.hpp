@@ -30,6 +30,6 @@ class Scratchpad : public ALabel {
   int count_;
   std::mutex mutex_;
   Ipc ipc_;
-  util::JsonParser parser_;
+  util::JsonParser parser_{TREE_UNUSED_MEMBERS};
 };
 }  // namespace waybar::modules::sway
@@ -2,26 +2,31 @@
 
 #include <fmt/format.h>
 
+#include <chrono>
 #include <tuple>
+#include <unordered_set>
 
 #include "AIconLabel.hpp"
 #include "bar.hpp"
 #include "client.hpp"
 #include "modules/sway/ipc/client.hpp"
 #include "util/json.hpp"
+#include "util/rewrite_title.hpp"
 
 namespace waybar::modules::sway {
 
 class Window : public AIconLabel, public sigc::trackable {
  public:
   Window(const std::string&, const waybar::Bar&, const Json::Value&);
-  virtual ~Window() = default;
+  virtual ~Window();
   auto update() -> void override;
 
  private:
   void setClass(std::string classname, bool enable);
   void onEvent(const struct Ipc::ipc_response&);
   void onCmd(const struct Ipc::ipc_response&);
+  void setTitle(const std::string& title);
+  void setFocusedWindow(const Json::Value& container);
   std::tuple<std::size_t, int, int, std::string, std::string, std::string, std::string, std::string>
   getFocusedNode(const Json::Value& nodes, std::string& output);
   void getTree();
@@ -41,7 +46,16 @@ class Window : public AIconLabel, public sigc::trackable {
   bool update_app_icon_{true};
   std::string app_icon_name_;
   int floating_count_;
-  util::JsonParser parser_;
+  // Windows of the workspace of the focused window, as of the last GET_TREE
+  std::unordered_set<int> workspace_windows_;
+  static constexpr std::chrono::milliseconds TITLE_UPDATE_INTERVAL{250};
+  std::chrono::steady_clock::time_point last_title_update_;
+  // Only the title changed since the last update, see update()
+  bool title_only_{false};
+  // Main thread only
+  sigc::connection title_timer_;
+  util::JsonParser parser_{TREE_UNUSED_MEMBERS};
+  util::RewriteRules rewrite_rules_;
   std::mutex mutex_;
   Ipc ipc_;
 };
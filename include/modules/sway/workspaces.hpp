@@ -30,6 +30,8 @@ class Workspaces : public AModule, public sigc::trackable {
 
   void onCmd(const struct Ipc::ipc_response&);
   void onEvent(const struct Ipc::ipc_response&);
+  bool applyEvent(const Json::Value&);
+  void updateWorkspaces();
   bool filterButtons();
   Gtk::Button& addButton(const Json::Value&);
   void onButtonReady(const Json::Value&, Gtk::Button&);
@@ -40,11 +42,16 @@ class Workspaces : public AModule, public sigc::trackable {
   bool handleScroll(GdkEventScroll*) override;
 
   const Bar& bar_;
+  // All the workspaces of sway, kept up to date with the workspace events
+  std::vector<Json::Value> sway_workspaces_;
+  // The workspaces shown, in order
   std::vector<Json::Value> workspaces_;
   std::vector<std::string> workspaces_order_;
   Gtk::Box box_;
   util::JsonParser parser_;
   std::unordered_map<std::string, Gtk::Button> buttons_;
+  // Workspace each button was last updated for
+  std::unordered_map<std::string, Json::Value> button_nodes_;
   std::mutex mutex_;
   Ipc ipc_;
 };
@@ -5,7 +5,7 @@
 #include <fstream>
 
 #include "ALabel.hpp"
-#include "util/sleeper_thread.hpp"
+#include "util/scheduler.hpp"
 
 namespace waybar::modules {
 
@@ -20,7 +20,7 @@ class Temperature : public ALabel {
   bool isCritical(uint16_t);
 
   std::string file_path_;
-  util::SleeperThread thread_;
+  util::Timer timer_;
 };
 
 }  // namespace waybar::modules
@@ -19,6 +19,7 @@
 #include "bar.hpp"
 #include "client.hpp"
 #include "giomm/desktopappinfo.h"
+#include "util/icon_loader.hpp"
 #include "util/json.hpp"
 #include "wlr-foreign-toplevel-management-unstable-v1-client-protocol.h"
 
@@ -56,6 +57,7 @@ class Task {
   Gtk::Button button_;
   Gtk::Box content_;
   Gtk::Image icon_;
+  util::IconRequest icon_request_;
   Gtk::Label text_before_;
   Gtk::Label text_after_;
   Glib::RefPtr<Gio::DesktopAppInfo> app_info_;
@@ -82,7 +84,7 @@ class Task {
   std::string repr() const;
   std::string state_string(bool = false) const;
   void set_app_info_from_app_id_list(const std::string &app_id_list);
-  bool image_load_icon(Gtk::Image &image, const Glib::RefPtr<Gtk::IconTheme> &icon_theme,
+  bool image_load_icon(Gtk::Image &image, const std::string &icon_theme,
                        Glib::RefPtr<Gio::DesktopAppInfo> app_info, int size);
   void hide_if_ignored();
 
@@ -145,7 +147,8 @@ class Taskbar : public waybar::AModule {
   Gtk::Box box_;
   std::vector<TaskPtr> tasks_;
 
-  std::vector<Glib::RefPtr<Gtk::IconTheme>> icon_themes_;
+  // Names of the icon themes to search, in order, "" being the default theme
+  std::vector<std::string> icon_themes_;
   std::unordered_set<std::string> ignore_list_;
   std::map<std::string, std::string> app_ids_replace_map_;
 
@@ -170,7 +173,7 @@ class Taskbar : public waybar::AModule {
   bool show_output(struct wl_output *) const;
   bool all_outputs() const;
 
-  const std::vector<Glib::RefPtr<Gtk::IconTheme>> &icon_themes() const;
+  const std::vector<std::string> &icon_themes() const;
   const std::unordered_set<std::string> &ignore_list() const;
   const std::map<std::string, std::string> &app_ids_replace_map() const;
 };
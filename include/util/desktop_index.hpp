@@ -0,0 +1,77 @@
+#pragma once
+
+#include <cstdint>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace waybar::util {
+
+/**
+ * Index of the desktop files of the XDG data dirs, persisted in the user cache dir.
+ *
+ * Maps the id of each desktop file (and its StartupWMClass) to the file and its icon, so that
+ * the icon of a window can be found without probing the data dirs or parsing desktop files. The
+ * index is written once and then mapped on the next starts, it is only rebuilt when the
+ * modification time of one of the `applications` directories changed.
+ *
+ * Lookups are thread-safe.
+ */
+class DesktopIndex {
+ public:
+  struct Entry {
+    std::string path;
+    // Value of the Icon key, a theme icon name or a path, may be empty
+    std::string icon;
+  };
+
+  /* Index of the XDG data dirs, stored in $XDG_CACHE_HOME/waybar */
+  static DesktopIndex& inst();
+
+  /* `data_dirs` by order of precedence, the index is saved to `cache_file` */
+  DesktopIndex(std::vector<std::string> data_dirs, std::string cache_file);
+  ~DesktopIndex();
+  DesktopIndex(const DesktopIndex&) = delete;
+  DesktopIndex& operator=(const DesktopIndex&) = delete;
+
+  /**
+   * Desktop file with the id `app_id` (the file name without ".desktop", also without an
+   * "org.kde." prefix), or else with `app_id` as its StartupWMClass.
+   */
+  std::optional<Entry> find(const std::string& app_id);
+
+  /* Check the directories again on the next lookup */
+  void invalidate();
+
+ private:
+  struct View {
+    std::string_view path;
+    std::string_view icon;
+  };
+
+  void load();
+  /* Fill the maps from `data`, with `validate` returns false if the index is outdated */
+  bool parse(std::string_view data, bool validate);
+  void build();
+  void save() const;
+  void reset();
+
+  const std::vector<std::string> data_dirs_;
+  const std::string cache_file_;
+
+  std::mutex mutex_;
+  bool valid_ = false;
+  // Contents of the index, either the mapped cache file or the index just built
+  std::string_view data_;
+  void* map_ = nullptr;
+  size_t map_size_ = 0;
+  std::string built_;
+  // Views into data_
+  std::unordered_map<std::string_view, View> ids_;
+  std::unordered_map<std::string_view, View> wm_classes_;
+};
+
+}  // namespace waybar::util
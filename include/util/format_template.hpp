@@ -0,0 +1,68 @@
+#pragma once
+
+#include <fmt/format.h>
+
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace waybar::util {
+
+/**
+ * A user format string parsed once.
+ *
+ * `fmt::format(fmt::runtime(format), ...)` parses the whole format string on every update. A
+ * template splits it into literal text and replacement fields up front, so rendering only has to
+ * format the fields, into a reused buffer. It also tells which named arguments the format refers
+ * to, letting modules skip values that would never be shown.
+ *
+ * The syntax is the one of fmt, fields are formatted by fmt itself so custom formatters (e.g.
+ * pow_format) keep working. Formats with nested replacement fields (`{:{}}`) are passed to fmt
+ * unchanged.
+ */
+class FormatTemplate {
+ public:
+  /* Throws fmt::format_error if the format is malformed */
+  explicit FormatTemplate(std::string format);
+
+  const std::string& str() const { return format_; }
+  bool empty() const { return format_.empty(); }
+  /* Whether the format has a field for the named argument */
+  bool uses(std::string_view name) const;
+
+  /* Same as fmt::format(fmt::runtime(format), args...) */
+  template <typename... Args>
+  std::string render(const Args&... args) const {
+    return vrender(fmt::make_format_args(args...));
+  }
+  std::string vrender(fmt::format_args args) const;
+
+ private:
+  struct Op {
+    // Literal text, or the format of the field ("{}" or "{:<spec>}")
+    std::string text;
+    bool field;
+    // Argument of the field, by name or by index if the name is empty
+    std::string name;
+    int index;
+  };
+
+  void parse();
+
+  std::string format_;
+  std::vector<Op> ops_;
+  bool nested_ = false;
+  mutable fmt::memory_buffer buffer_;
+};
+
+/* Templates of the formats used by a module, each compiled on its first use */
+class FormatCache {
+ public:
+  const FormatTemplate& get(const std::string& format);
+
+ private:
+  std::unordered_map<std::string, FormatTemplate> templates_;
+};
+
+}  // namespace waybar::util
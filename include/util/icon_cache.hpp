@@ -0,0 +1,91 @@
+#pragma once
+
+#include <cairomm/surface.h>
+#include <gdkmm/pixbuf.h>
+#include <giomm/desktopappinfo.h>
+#include <glibmm/main.h>
+#include <gtkmm/icontheme.h>
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+
+#include "util/icon_loader.hpp"
+#include "util/lru_cache.hpp"
+
+namespace waybar::util {
+
+/**
+ * Process-wide cache of desktop entries and icons.
+ *
+ * Resolving the icon of a window means probing desktop files across the XDG data dirs and
+ * decoding and scaling an image, which every taskbar button, window title and tray item used to
+ * do on its own. Results are shared between modules and bars, misses are cached as well so that
+ * unknown app_ids are not looked up again for every new window.
+ *
+ * Everything is dropped when the `applications` or `icons` directories of the XDG data dirs
+ * change (watched with inotify) or when the default icon theme changes.
+ *
+ * Lookups are thread-safe, but loading icons uses GTK and must happen on the main thread. Icon
+ * files are decoded and scaled by the IconLoader workers.
+ */
+class IconCache {
+ public:
+  using AppInfo = Glib::RefPtr<Gio::DesktopAppInfo>;
+
+  static IconCache& inst();
+
+  /**
+   * Desktop entry for `key` (usually an app_id), computed by `resolve` on the first request.
+   * `resolve` runs without the cache locked and must not call back into it.
+   */
+  AppInfo appInfo(const std::string& key, const std::function<AppInfo()>& resolve);
+  /* Same as appInfo() for icon names, an empty name is a cached miss */
+  std::string iconName(const std::string& key, const std::function<std::string()>& resolve);
+
+  /* Icon theme of the given name shared by all the modules, "" is the default theme */
+  Glib::RefPtr<Gtk::IconTheme> theme(const std::string& name);
+  /**
+   * Load the icon `icon` (a theme icon name or a file path) from the theme `theme`, scaled to
+   * `size` pixels at `scale`, and pass its surface to `done`: right away if it is cached, else
+   * once `request` decoded it on a worker thread. `done` gets a null pointer if the icon file
+   * can't be decoded.
+   * Returns false without calling `done` if the theme has no such icon. Main thread only.
+   */
+  bool loadIcon(IconRequest& request, const std::string& theme, const std::string& icon, int size,
+                int scale, std::function<void(Cairo::RefPtr<Cairo::Surface>)> done);
+
+  /* Drop every cached entry */
+  void clear();
+
+ private:
+  IconCache();
+  // Pixbuf decoded for all the requests of the same icon, by the first one to run
+  struct Decoding {
+    std::once_flag once;
+    Glib::RefPtr<Gdk::Pixbuf> pixbuf;
+  };
+
+  void watch();
+  bool onChange(Glib::IOCondition cond);
+  void store(const std::string& key, uint64_t generation, Cairo::RefPtr<Cairo::Surface> surface);
+
+  std::mutex mutex_;
+  // Bumped by clear(), results resolved before it are not stored
+  uint64_t generation_ = 0;
+  LruCache<std::string, AppInfo> app_infos_{256};
+  LruCache<std::string, std::string> icon_names_{256};
+  // Keyed by theme, icon, size and scale
+  LruCache<std::string, Cairo::RefPtr<Cairo::Surface>> surfaces_{256};
+  std::unordered_map<std::string, std::shared_ptr<Decoding>> decoding_;
+  std::unordered_map<std::string, Glib::RefPtr<Gtk::IconTheme>> themes_;
+  int inotify_fd_ = -1;
+  // Watch descriptors of the data dirs themselves, the others are their subdirs
+  std::unordered_set<int> data_dir_watches_;
+};
+
+}  // namespace waybar::util
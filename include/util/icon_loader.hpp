@@ -0,0 +1,92 @@
+#pragma once
+
+#include <gdkmm/pixbuf.h>
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "util/SafeSignal.hpp"
+
+namespace waybar::util {
+
+/**
+ * Pool of worker threads decoding and scaling icons.
+ *
+ * Decoding an image file, an SVG in particular, can take long enough to drop frames when it is
+ * done on the main thread. The decoding function of a request runs on a worker and its result is
+ * passed back to the main thread through a SafeSignal.
+ *
+ * Decoding functions must not use GTK: resolve the icon (e.g. with Gtk::IconTheme::lookup_icon)
+ * beforehand on the main thread and only load its file on the worker.
+ */
+class IconLoader {
+ public:
+  using Pixbuf = Glib::RefPtr<Gdk::Pixbuf>;
+  using id_t = uint64_t;
+
+  /* Must first be called from the main thread */
+  static IconLoader& inst();
+
+  /* Run `decode` on a worker, then `done` with its result on the main thread */
+  id_t post(std::function<Pixbuf()> decode, std::function<void(Pixbuf)> done);
+  /* Forget a request, `done` won't be called. Called from the main thread. */
+  void cancel(id_t id);
+
+ private:
+  IconLoader();
+  void run();
+  void finish(id_t id, Pixbuf pixbuf);
+
+  std::mutex mutex_;
+  std::condition_variable condvar_;
+  std::deque<std::pair<id_t, std::function<Pixbuf()>>> jobs_;
+  // Callbacks of the requests not finished nor cancelled
+  std::unordered_map<id_t, std::function<void(Pixbuf)>> pending_;
+  id_t next_id_ = 1;
+  SafeSignal<id_t, Pixbuf> finished_;
+  std::vector<std::thread> threads_;
+};
+
+/**
+ * Icon being loaded for a widget.
+ * Starting a new request cancels the previous one, so only the latest icon is shown, and the
+ * request is cancelled when the widget is destroyed.
+ */
+class IconRequest {
+ public:
+  IconRequest() = default;
+  IconRequest(const IconRequest&) = delete;
+  IconRequest& operator=(const IconRequest&) = delete;
+  ~IconRequest() { cancel(); }
+
+  void start(std::function<IconLoader::Pixbuf()> decode,
+             std::function<void(IconLoader::Pixbuf)> done) {
+    cancel();
+    id_ = IconLoader::inst().post(std::move(decode),
+                                  [this, done = std::move(done)](IconLoader::Pixbuf pixbuf) {
+                                    id_ = 0;
+                                    done(std::move(pixbuf));
+                                  });
+  }
+
+  bool pending() const { return id_ != 0; }
+
+  void cancel() {
+    if (id_ != 0) {
+      IconLoader::inst().cancel(id_);
+      id_ = 0;
+    }
+  }
+
+ private:
+  IconLoader::id_t id_ = 0;
+};
+
+}  // namespace waybar::util
@@ -3,6 +3,12 @@
 #include <fmt/ostream.h>
 #include <json/json.h>
 
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+#include <string_view>
+
 #if (FMT_VERSION >= 90000)
 
 template <>
@@ -12,17 +18,42 @@ struct fmt::formatter<Json::Value> : ostream_formatter {};
 
 namespace waybar::util {
 
+/**
+ * Parses JSON documents, the config as well as the sway and hyprland IPC payloads.
+ *
+ * The reader is created once and reused for all the documents, and comments are skipped rather
+ * than attached to the values.
+ *
+ * Building the values is most of the time spent parsing, a parser can be given the names of
+ * members its user never reads (e.g. the geometry of every container of a sway GET_TREE reply):
+ * they are cut out of the document, at any depth, before it is parsed.
+ */
 struct JsonParser {
-  JsonParser() {}
+  JsonParser() { builder_["collectComments"] = false; }
+  explicit JsonParser(std::set<std::string, std::less<>> skipped) : JsonParser() {
+    skipped_ = std::move(skipped);
+  }
 
-  const Json::Value parse(const std::string& data) const {
+  const Json::Value parse(std::string_view data) const {
     Json::Value root(Json::objectValue);
     if (data.empty()) {
       return root;
     }
-    std::unique_ptr<Json::CharReader> const reader(builder_.newCharReader());
+    std::string filtered;
+    if (!skipped_.empty()) {
+      filtered = skipMembers(data);
+      data = filtered;
+    }
     std::string err;
-    bool res = reader->parse(data.c_str(), data.c_str() + data.size(), &root, &err);
+    bool res;
+    {
+      // A reader keeps the state of the document being parsed, parsers may be shared by threads
+      std::lock_guard<std::mutex> lock(mutex_);
+      if (!reader_) {
+        reader_.reset(builder_.newCharReader());
+      }
+      res = reader_->parse(data.data(), data.data() + data.size(), &root, &err);
+    }
     if (!res) throw std::runtime_error(err);
     return root;
   }
@@ -30,7 +61,12 @@ struct JsonParser {
   ~JsonParser() = default;
 
  private:
+  std::string skipMembers(std::string_view data) const;
+
   Json::CharReaderBuilder builder_;
+  std::set<std::string, std::less<>> skipped_;
+  mutable std::mutex mutex_;
+  mutable std::unique_ptr<Json::CharReader> reader_;
 };
 
 }  // namespace waybar::util
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <cstddef>
+#include <list>
+#include <unordered_map>
+#include <utility>
+
+namespace waybar::util {
+
+/**
+ * Map of bounded size evicting the least recently used entry.
+ * Not thread-safe, callers synchronize access.
+ */
+template <typename K, typename V>
+class LruCache {
+ public:
+  explicit LruCache(size_t capacity) : capacity_(capacity > 0 ? capacity : 1) {}
+
+  /* Value of `key` or nullptr, marks the entry as most recently used */
+  const V* get(const K& key) {
+    auto it = index_.find(key);
+    if (it == index_.end()) {
+      return nullptr;
+    }
+    entries_.splice(entries_.begin(), entries_, it->second);
+    return &it->second->second;
+  }
+
+  /* Insert or replace the value of `key`, evicting the oldest entry if the cache is full */
+  const V& put(const K& key, V value) {
+    auto it = index_.find(key);
+    if (it != index_.end()) {
+      it->second->second = std::move(value);
+      entries_.splice(entries_.begin(), entries_, it->second);
+      return it->second->second;
+    }
+    if (entries_.size() >= capacity_) {
+      index_.erase(entries_.back().first);
+      entries_.pop_back();
+    }
+    entries_.emplace_front(key, std::move(value));
+    index_.emplace(key, entries_.begin());
+    return entries_.front().second;
+  }
+
+  size_t size() const { return entries_.size(); }
+  void clear() {
+    index_.clear();
+    entries_.clear();
+  }
+
+ private:
+  const size_t capacity_;
+  // Most recently used first
+  std::list<std::pair<K, V>> entries_;
+  std::unordered_map<K, typename std::list<std::pair<K, V>>::iterator> index_;
+};
+
+}  // namespace waybar::util
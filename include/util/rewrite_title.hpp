@@ -1,8 +1,38 @@
 #pragma once
 #include <json/json.h>
 
+#include <regex>
 #include <string>
+#include <vector>
+
+#include "util/lru_cache.hpp"
 
 namespace waybar::util {
-std::string rewriteTitle(const std::string&, const Json::Value&);
-}
+
+/**
+ * The "rewrite" rules of a module, compiled once.
+ *
+ * Each rule whose regex matches the whole title replaces its matches in the result of the
+ * previous rules. Regexes are only built when the config is read, rules starting with a literal
+ * are skipped without running the regex when the title does not start with it, and recent titles
+ * are remembered as windows often go back and forth between a few titles.
+ */
+class RewriteRules {
+ public:
+  /* Invalid rules are logged and ignored */
+  explicit RewriteRules(const Json::Value& rules);
+
+  std::string apply(const std::string& title);
+
+ private:
+  struct Rule {
+    // Text any matching title starts with, may be empty
+    std::string prefix;
+    std::regex regex;
+    std::string replacement;
+  };
+
+  std::vector<Rule> rules_;
+  LruCache<std::string, std::string> cache_;
+};
+}  // namespace waybar::util
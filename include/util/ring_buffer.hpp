@@ -0,0 +1,60 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+namespace waybar::util {
+
+/**
+ * Fixed-capacity history of several series sampled together (e.g. one per cpu core).
+ *
+ * Values are stored series by series (structure of arrays): reading the history of one series is
+ * a contiguous scan, and pushing a new sample only writes the newest column.
+ */
+template <typename T>
+class RingBuffer {
+ public:
+  explicit RingBuffer(size_t capacity) : capacity_(capacity > 0 ? capacity : 1) {}
+
+  size_t capacity() const { return capacity_; }
+  /* Number of samples currently stored, at most capacity() */
+  size_t size() const { return size_; }
+  size_t series() const { return series_; }
+
+  /* Add a sample with one value per series. The history restarts if the series count changes. */
+  template <typename Column>
+  void push(const Column& column) {
+    if (column.size() != series_) {
+      series_ = column.size();
+      data_.assign(series_ * capacity_, T{});
+      head_ = 0;
+      size_ = 0;
+    }
+    for (size_t s = 0; s < series_; ++s) {
+      data_[s * capacity_ + head_] = column[s];
+    }
+    head_ = (head_ + 1) % capacity_;
+    if (size_ < capacity_) {
+      ++size_;
+    }
+  }
+
+  /* i-th value of series s, from the oldest (0) to the newest (size() - 1) */
+  const T& at(size_t s, size_t i) const {
+    return data_[s * capacity_ + (head_ + capacity_ - size_ + i) % capacity_];
+  }
+
+  /* Most recent value of series s, size() must not be zero */
+  const T& back(size_t s) const {
+    return data_[s * capacity_ + (head_ + capacity_ - 1) % capacity_];
+  }
+
+ private:
+  const size_t capacity_;
+  size_t series_ = 0;
+  size_t head_ = 0;
+  size_t size_ = 0;
+  std::vector<T> data_;
+};
+
+}  // namespace waybar::util
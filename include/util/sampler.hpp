@@ -0,0 +1,107 @@
+#pragma once
+
+#include <chrono>
+#include <exception>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+
+#include "util/SafeSignal.hpp"
+#include "util/scheduler.hpp"
+
+namespace waybar::util {
+
+/**
+ * Data source shared between module instances.
+ *
+ * With several outputs every bar creates its own instance of a module, and each of them used to
+ * read the same system files independently. Modules with the same key now share one Sampler: the
+ * sampling function runs once per interval on the scheduler thread and the result is passed to
+ * every subscriber on the main thread. Formatting stays in the modules, so per-bar settings such as
+ * `format` or `tooltip-format` keep working.
+ */
+template <typename T>
+class Sampler {
+ public:
+  using sample_ptr = std::shared_ptr<const T>;
+
+  /**
+   * Get the sampler for `key`, creating it if there is none yet.
+   * The key must include everything that affects sampling (e.g. the interval or a path), as
+   * the sampling function of the first caller is used for all the instances sharing it.
+   * With `warmup` set, the result of the first call is dropped: it only takes the baseline of
+   * counters (e.g. cpu times), and the first sample is taken WARMUP_DELAY later.
+   */
+  static std::shared_ptr<Sampler> get(const std::string& key,
+                                      std::chrono::system_clock::duration interval,
+                                      std::function<T()> func, bool warmup = false) {
+    static std::mutex mutex;
+    static std::map<std::string, std::weak_ptr<Sampler>> samplers;
+
+    std::lock_guard<std::mutex> lock(mutex);
+    auto& weak = samplers[key];
+    auto sampler = weak.lock();
+    if (!sampler) {
+      sampler.reset(new Sampler(std::move(func), warmup));
+      sampler->timer_.start(interval, [s = sampler.get()] { s->sample(); });
+      weak = sampler;
+    }
+    return sampler;
+  }
+
+  /* Latest sample, nullptr until the first one is taken. Rethrows the error of a failed sample. */
+  sample_ptr latest() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (error_) {
+      std::rethrow_exception(error_);
+    }
+    return latest_;
+  }
+
+  /* Force a new sample outside of the regular interval */
+  void wake_up() { timer_.wake_up(); }
+
+  /* Emitted on the main thread whenever a new sample is available */
+  SafeSignal<> signal_sample;
+
+ private:
+  static constexpr auto WARMUP_DELAY = std::chrono::milliseconds(100);
+
+  Sampler(std::function<T()> func, bool warmup) : func_(std::move(func)), warmup_(warmup) {}
+
+  void sample() {
+    if (warmup_) {
+      // Only the scheduler thread reads it
+      warmup_ = false;
+      try {
+        func_();
+      } catch (...) {
+        // Reported by the next call if it fails again
+      }
+      timer_.wake_up(WARMUP_DELAY);
+      return;
+    }
+    try {
+      auto value = std::make_shared<const T>(func_());
+      std::lock_guard<std::mutex> lock(mutex_);
+      latest_ = std::move(value);
+      error_ = nullptr;
+    } catch (...) {
+      std::lock_guard<std::mutex> lock(mutex_);
+      error_ = std::current_exception();
+    }
+    signal_sample.emit();
+  }
+
+  mutable std::mutex mutex_;
+  std::function<T()> func_;
+  sample_ptr latest_;
+  std::exception_ptr error_;
+  bool warmup_;
+  // Must be destroyed first: the callback uses all the members above
+  Timer timer_;
+};
+
+}  // namespace waybar::util
@@ -0,0 +1,124 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <thread>
+
+namespace waybar::util {
+
+/**
+ * Process-wide timer scheduler.
+ *
+ * Runs the periodic callbacks of all interval-driven modules on a single worker thread, instead of
+ * keeping one mostly idle SleeperThread per module and per bar.
+ * Callbacks must be short (usually just a `dp.emit()`): anything that may block for a noticeable
+ * time delays every other timer and belongs in a dedicated thread.
+ */
+class Scheduler {
+ public:
+  using clock = std::chrono::system_clock;
+  using id_t = uint64_t;
+
+  static Scheduler& inst();
+
+  /**
+   * Register a periodic callback. The callback is invoked as soon as possible and then every
+   * `interval`. With `aligned` set, subsequent invocations are aligned to multiples of `interval`
+   * since the epoch (e.g. full minutes for a clock).
+   * `id` is assigned before the first invocation, so the callback may safely remove itself.
+   */
+  void add(id_t& id, clock::duration interval, std::function<void()> func, bool aligned = false);
+  /**
+   * Unregister a callback. Blocks until the callback finishes if it is currently running on the
+   * scheduler thread.
+   */
+  void remove(id_t id);
+  /**
+   * Invoke the callback after `delay` (as soon as possible by default) and restart its interval
+   * afterwards.
+   */
+  void wakeUp(id_t id, clock::duration delay = clock::duration::zero());
+  /**
+   * Coalesce wakeups: deadlines of timers with an interval of at least one second (and not
+   * shorter than `slack`) are rounded to the nearest multiple of `slack`, so that they fire
+   * together in a single burst. The value is also used as the kernel timer slack of the scheduler
+   * thread while no aligned timer is registered. When requested several times, the largest value
+   * wins.
+   */
+  void setSlack(clock::duration slack);
+  /* Forget the slack requested so far, e.g. before the bars are created again */
+  void resetSlack();
+
+ private:
+  struct Entry {
+    clock::duration interval;
+    bool aligned;
+    std::function<void()> func;
+    std::multimap<clock::time_point, id_t>::iterator pos;
+    bool queued = false;
+    bool woken = false;
+    clock::duration wake_delay{0};
+  };
+
+  Scheduler();
+  void run();
+  void schedule(id_t id, Entry& entry, clock::time_point deadline);
+  void unschedule(Entry& entry);
+  clock::time_point nextDeadline(const Entry& entry, clock::time_point now) const;
+
+  std::mutex mutex_;
+  std::condition_variable condvar_;
+  std::condition_variable done_;
+  std::map<id_t, Entry> timers_;
+  std::multimap<clock::time_point, id_t> queue_;
+  id_t next_id_ = 1;
+  id_t running_ = 0;
+  clock::duration slack_{0};
+  // Number of aligned timers registered
+  size_t aligned_count_ = 0;
+  // Timer slack currently applied to the scheduler thread
+  clock::duration thread_slack_{0};
+  std::thread thread_;
+};
+
+/**
+ * RAII handle for a periodic callback registered with the Scheduler.
+ * Mirrors the SleeperThread interface used by the modules.
+ */
+class Timer {
+ public:
+  Timer() = default;
+  Timer(const Timer&) = delete;
+  Timer& operator=(const Timer&) = delete;
+  ~Timer() { stop(); }
+
+  void start(std::chrono::system_clock::duration interval, std::function<void()> func,
+             bool aligned = false) {
+    stop();
+    Scheduler::inst().add(id_, interval, std::move(func), aligned);
+  }
+
+  bool isRunning() const { return id_ != 0; }
+
+  void wake_up(Scheduler::clock::duration delay = Scheduler::clock::duration::zero()) {
+    if (id_ != 0) {
+      Scheduler::inst().wakeUp(id_, delay);
+    }
+  }
+
+  void stop() {
+    if (id_ != 0) {
+      Scheduler::inst().remove(id_);
+      id_ = 0;
+    }
+  }
+
+ private:
+  Scheduler::id_t id_ = 0;
+};
+
+}  // namespace waybar::util
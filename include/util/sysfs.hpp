@@ -0,0 +1,49 @@
+#pragma once
+
+#include <sys/types.h>
+
+#include <array>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <optional>
+#include <string>
+#include <string_view>
+
+namespace waybar::util {
+
+/**
+ * Attribute files of a sysfs device directory, such as a power supply.
+ *
+ * Each attribute is opened on its first read and the descriptor is kept, so reading it again is a
+ * single pread. Missing attributes are remembered and never looked up again: create a new
+ * instance when the device may have changed.
+ */
+class SysfsDevice {
+ public:
+  explicit SysfsDevice(const std::string& path);
+  ~SysfsDevice();
+  SysfsDevice(const SysfsDevice&) = delete;
+  SysfsDevice& operator=(const SysfsDevice&) = delete;
+
+  const std::string& path() const { return path_; }
+
+  bool exists(std::string_view name);
+  /* Absolute value of a numeric attribute, nullopt if it is missing or can't be read */
+  std::optional<uint64_t> readNumber(std::string_view name);
+  /* First line of a text attribute, nullopt if it is missing or can't be read */
+  std::optional<std::string> readString(std::string_view name);
+
+ private:
+  int fd(std::string_view name);
+  /* Read an attribute into buffer_, returns its length or -1 */
+  ssize_t read(std::string_view name);
+
+  std::string path_;
+  int dir_fd_;
+  // Descriptor of each attribute already looked up, -1 for missing ones
+  std::map<std::string, int, std::less<>> fds_;
+  std::array<char, 256> buffer_;
+};
+
+}  // namespace waybar::util
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+namespace waybar::util {
+
+/**
+ * Display width of UTF-8 text, in columns.
+ *
+ * Wide (East Asian and emoji) characters take two columns, combining and other zero-width
+ * characters none, using the Unicode tables of GLib. Pure ASCII text skips the tables entirely.
+ * Text is handled by grapheme clusters (a character with its combining marks, emoji sequences,
+ * flags), so that truncating never splits one.
+ */
+
+/* Columns taken by a single code point */
+int charWidth(char32_t c);
+
+size_t textWidth(std::string_view text);
+
+/**
+ * Cut `text` so that it takes at most `width` columns, ellipsis included. Text that fits is
+ * returned as is, trailing spaces before the ellipsis are dropped.
+ */
+std::string truncateText(std::string_view text, size_t width, std::string_view ellipsis = "…");
+
+/**
+ * Same as truncateText for Pango markup: only the text between tags is counted, an entity is one
+ * character, and all the tags are kept so that the markup stays valid.
+ */
+std::string truncateMarkup(std::string_view markup, size_t width,
+                           std::string_view ellipsis = "…");
+
+}  // namespace waybar::util
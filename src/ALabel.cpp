@@ -1,9 +1,14 @@
 #include "ALabel.hpp"
 
 #include <fmt/format.h>
+#include <glibmm/main.h>
+
+#include <utility>
 
 #include <util/command.hpp>
 
+#include "util/text_width.hpp"
+
 namespace waybar {
 
 ALabel::ALabel(const Json::Value& config, const std::string& name, const std::string& id,
@@ -22,8 +27,7 @@ ALabel::ALabel(const Json::Value& config, const std::string& name, const std::st
   }
   event_box_.add(label_);
   if (config_["max-length"].isUInt()) {
-    label_.set_max_width_chars(config_["max-length"].asInt());
-    label_.set_ellipsize(Pango::EllipsizeMode::ELLIPSIZE_END);
+    max_length_ = config_["max-length"].asUInt();
     label_.set_single_line_mode(true);
   } else if (ellipsize && label_.get_max_width_chars() == -1) {
     label_.set_ellipsize(Pango::EllipsizeMode::ELLIPSIZE_END);
@@ -51,6 +55,8 @@ ALabel::ALabel(const Json::Value& config, const std::string& name, const std::st
   }
 }
 
+ALabel::~ALabel() { tooltip_refresh_conn_.disconnect(); }
+
 auto ALabel::update() -> void { AModule::update(); }
 
 std::string ALabel::getIcon(uint16_t percentage, const std::string& alt, uint16_t max) {
@@ -133,13 +139,109 @@ std::string ALabel::getState(uint8_t value, bool lesser) {
   std::string valid_state;
   for (auto const& state : states) {
     if ((lesser ? value <= state.second : value >= state.second) && valid_state.empty()) {
-      label_.get_style_context()->add_class(state.first);
+      setClass(state.first, true);
       valid_state = state.first;
     } else {
-      label_.get_style_context()->remove_class(state.first);
+      setClass(state.first, false);
     }
   }
   return valid_state;
 }
 
+void ALabel::setMarkup(const std::string& markup) {
+  if (changed(markup_, markup)) {
+    label_.set_markup(max_length_ > 0 ? util::truncateMarkup(markup, max_length_) : markup);
+  }
+}
+
+void ALabel::setTooltipText(const std::string& text) {
+  tooltip_render_ = nullptr;
+  // Switching between text and markup always updates the tooltip
+  bool was_markup = std::exchange(tooltip_markup_, false);
+  if (changed(tooltip_, text) || was_markup) {
+    label_.set_tooltip_text(text);
+  }
+}
+
+void ALabel::setTooltipMarkup(const std::string& markup) {
+  tooltip_render_ = nullptr;
+  bool was_markup = std::exchange(tooltip_markup_, true);
+  if (changed(tooltip_, markup) || !was_markup) {
+    label_.set_tooltip_markup(markup);
+  }
+}
+
+void ALabel::setClass(const std::string& name, bool enabled) {
+  ++render_stats_.requested;
+  auto it = classes_.find(name);
+  if ((it != classes_.end()) == enabled) {
+    ++render_stats_.skipped;
+    return;
+  }
+  if (enabled) {
+    classes_.insert(it, name);
+    label_.get_style_context()->add_class(name);
+  } else {
+    classes_.erase(it);
+    label_.get_style_context()->remove_class(name);
+  }
+}
+
+void ALabel::setTooltipRenderer(std::function<std::string()> render, bool markup) {
+  if (!query_tooltip_conn_.connected()) {
+    // Connected before the default handler, which would show the static tooltip instead
+    query_tooltip_conn_ = label_.signal_query_tooltip().connect(
+        sigc::mem_fun(*this, &ALabel::handleQueryTooltip), false);
+    event_box_.add_events(Gdk::ENTER_NOTIFY_MASK | Gdk::LEAVE_NOTIFY_MASK);
+    event_box_.signal_enter_notify_event().connect([this](GdkEventCrossing*) {
+      hovered_ = true;
+      return false;
+    });
+    event_box_.signal_leave_notify_event().connect([this](GdkEventCrossing* e) {
+      hovered_ = e->detail == GDK_NOTIFY_INFERIOR;
+      return false;
+    });
+  }
+  if (!tooltip_.empty()) {
+    label_.set_tooltip_text("");
+    tooltip_.clear();
+  }
+  tooltip_render_ = std::move(render);
+  tooltip_render_markup_ = markup;
+  ++tooltip_version_;
+  label_.set_has_tooltip(true);
+  if (hovered_ && !tooltip_refresh_conn_.connected()) {
+    // The tooltip may be shown, have it rendered again once the update is done
+    tooltip_refresh_conn_ = Glib::signal_idle().connect([this] {
+      label_.trigger_tooltip_query();
+      return false;
+    });
+  }
+}
+
+bool ALabel::handleQueryTooltip(int /*x*/, int /*y*/, bool /*keyboard*/,
+                                const Glib::RefPtr<Gtk::Tooltip>& tooltip) {
+  if (!tooltip_render_) {
+    return false;
+  }
+  if (tooltip_rendered_ != tooltip_version_) {
+    try {
+      tooltip_cache_ = tooltip_render_();
+    } catch (const std::exception& e) {
+      spdlog::error("{}: {}", name_, e.what());
+      tooltip_cache_.clear();
+    }
+    tooltip_rendered_ = tooltip_version_;
+  }
+  if (tooltip_cache_.empty()) {
+    return false;
+  }
+  if (tooltip_render_markup_) {
+    tooltip->set_markup(tooltip_cache_);
+  } else {
+    tooltip->set_text(tooltip_cache_);
+  }
+  return true;
+}
+
 }  // namespace waybar
@@ -49,6 +49,10 @@ AModule::AModule(const Json::Value& config, const std::string& name, const std::
 }
 
 AModule::~AModule() {
+  if (render_stats_.requested > 0) {
+    spdlog::debug("{}: skipped {} of {} widget updates", name_, render_stats_.skipped,
+                  render_stats_.requested);
+  }
   for (const auto& pid : pid_) {
     if (pid != -1) {
       killpg(pid, SIGTERM);
@@ -167,6 +171,16 @@ bool AModule::handleScroll(GdkEventScroll* e) {
   return true;
 }
 
+bool AModule::changed(std::string& last, const std::string& value) {
+  ++render_stats_.requested;
+  if (value == last) {
+    ++render_stats_.skipped;
+    return false;
+  }
+  last = value;
+  return true;
+}
+
 bool AModule::tooltipEnabled() {
   return config_["tooltip"].isBool() ? config_["tooltip"].asBool() : true;
 }
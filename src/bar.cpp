@@ -10,6 +10,7 @@
 #include "client.hpp"
 #include "factory.hpp"
 #include "group.hpp"
+#include "util/scheduler.hpp"
 #include "wlr-layer-shell-unstable-v1-client-protocol.h"
 
 #ifdef HAVE_SWAY
@@ -513,6 +514,10 @@ waybar::Bar::Bar(struct waybar_output* w_output, const Json::Value& w_config)
     right_.set_spacing(spacing);
   }
 
+  if (config["timer-slack"].isUInt()) {
+    util::Scheduler::inst().setSlack(std::chrono::milliseconds(config["timer-slack"].asUInt()));
+  }
+
   uint32_t height = config["height"].isUInt() ? config["height"].asUInt() : 0;
   uint32_t width = config["width"].isUInt() ? config["width"].asUInt() : 0;
 
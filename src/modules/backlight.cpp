@@ -190,9 +190,9 @@ auto waybar::modules::Backlight::update() -> void {
       event_box_.show();
       const uint8_t percent =
           best->get_max() == 0 ? 100 : round(best->get_actual() * 100.0f / best->get_max());
-      label_.set_markup(fmt::format(fmt::runtime(format_),
-                                    fmt::arg("percent", std::to_string(percent)),
-                                    fmt::arg("icon", getIcon(percent))));
+      setMarkup(fmt::format(fmt::runtime(format_),
+                            fmt::arg("percent", std::to_string(percent)),
+                            fmt::arg("icon", getIcon(percent))));
       getState(percent);
     } else {
       event_box_.hide();
@@ -201,7 +201,7 @@ auto waybar::modules::Backlight::update() -> void {
     if (!previous_best_.has_value()) {
       return;
     }
-    label_.set_markup("");
+    setMarkup("");
   }
   previous_best_ = best == nullptr ? std::nullopt : std::optional{*best};
   previous_format_ = format_;
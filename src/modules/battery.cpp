@@ -2,12 +2,25 @@
 #if defined(__FreeBSD__)
 #include <sys/sysctl.h>
 #endif
+#if defined(__linux__) && defined(HAVE_LIBUDEV)
+#include <glibmm/main.h>
+#include <libudev.h>
+#endif
 #include <spdlog/spdlog.h>
 
+#include <cstring>
 #include <iostream>
 waybar::modules::Battery::Battery(const std::string& id, const Json::Value& config)
     : ALabel(config, "battery", id, "{capacity}%", 60) {
 #if defined(__linux__)
+#if defined(HAVE_LIBUDEV)
+  if (startUdevMonitor()) {
+    refreshBatteries();
+    worker();
+    return;
+  }
+  spdlog::warn("Battery: can't monitor udev events, watching {} instead", data_dir_.string());
+#endif
   battery_watch_fd_ = inotify_init1(IN_CLOEXEC);
   if (battery_watch_fd_ == -1) {
     throw std::runtime_error("Unable to listen batteries.");
@@ -28,39 +41,108 @@ waybar::modules::Battery::Battery(const std::string& id, const Json::Value& conf
 }
 
 waybar::modules::Battery::~Battery() {
+  timer_.stop();
 #if defined(__linux__)
+#if defined(HAVE_LIBUDEV)
+  udev_conn_.disconnect();
+  if (udev_monitor_ != nullptr) {
+    udev_monitor_unref(udev_monitor_);
+  }
+  if (udev_ != nullptr) {
+    udev_unref(udev_);
+  }
+#endif
   std::lock_guard<std::mutex> guard(battery_list_mutex_);
 
   if (global_watch >= 0) {
     inotify_rm_watch(global_watch_fd_, global_watch);
   }
-  close(global_watch_fd_);
+  if (global_watch_fd_ >= 0) {
+    close(global_watch_fd_);
+  }
 
-  for (auto it = batteries_.cbegin(); it != batteries_.cend(); it++) {
-    auto watch_id = (*it).second;
+  for (auto const& bat : batteries_) {
+    auto watch_id = bat.second.watch;
     if (watch_id >= 0) {
       inotify_rm_watch(battery_watch_fd_, watch_id);
     }
-    batteries_.erase(it);
   }
-  close(battery_watch_fd_);
+  batteries_.clear();
+  if (battery_watch_fd_ >= 0) {
+    close(battery_watch_fd_);
+  }
 #endif
 }
 
+#if defined(__linux__) && defined(HAVE_LIBUDEV)
+bool waybar::modules::Battery::startUdevMonitor() {
+  udev_ = udev_new();
+  if (udev_ == nullptr) {
+    return false;
+  }
+  udev_monitor_ = udev_monitor_new_from_netlink(udev_, "udev");
+  if (udev_monitor_ == nullptr ||
+      udev_monitor_filter_add_match_subsystem_devtype(udev_monitor_, "power_supply", nullptr) < 0 ||
+      udev_monitor_enable_receiving(udev_monitor_) < 0) {
+    return false;
+  }
+  udev_conn_ = Glib::signal_io().connect(sigc::mem_fun(*this, &Battery::handleUdevEvent),
+                                         udev_monitor_get_fd(udev_monitor_),
+                                         Glib::IO_IN | Glib::IO_ERR | Glib::IO_HUP);
+  return true;
+}
+
+bool waybar::modules::Battery::handleUdevEvent(Glib::IOCondition cond) {
+  if (!(cond & Glib::IO_IN)) {
+    spdlog::error("Battery: udev monitor failed");
+    return false;
+  }
+  std::unique_ptr<udev_device, decltype(&udev_device_unref)> dev{
+      udev_monitor_receive_device(udev_monitor_), &udev_device_unref};
+  if (!dev) {
+    return true;
+  }
+  const char* action = udev_device_get_action(dev.get());
+  if (action != nullptr &&
+      (std::strcmp(action, "add") == 0 || std::strcmp(action, "remove") == 0)) {
+    try {
+      refreshBatteries();
+    } catch (const std::exception& e) {
+      spdlog::error("Battery: {}", e.what());
+    }
+    dp.emit();
+    return true;
+  }
+  // Only update for the supplies shown by the module, not e.g. for the battery of a mouse
+  auto path = data_dir_ / udev_device_get_sysname(dev.get());
+  bool shown;
+  {
+    std::lock_guard<std::mutex> guard(battery_list_mutex_);
+    shown = batteries_.count(path) != 0 || (adapter_ && adapter_->path() == path.string());
+  }
+  if (shown) {
+    dp.emit();
+  }
+  return true;
+}
+#endif
+
 void waybar::modules::Battery::worker() {
 #if defined(__FreeBSD__)
-  thread_timer_ = [this] {
-    dp.emit();
-    thread_timer_.sleep_for(interval_);
-  };
+  timer_.start(interval_, [this] { dp.emit(); });
 #else
-  thread_timer_ = [this] {
+  if (battery_watch_fd_ == -1) {
+    // udev reports added and removed batteries, the timer only catches up with the charge of
+    // batteries that don't send change events
+    timer_.start(interval_, [this] { dp.emit(); });
+    return;
+  }
+  timer_.start(interval_, [this] {
     // Make sure we eventually update the list of batteries even if we miss an
     // inotify event for some reason
     refreshBatteries();
     dp.emit();
-    thread_timer_.sleep_for(interval_);
-  };
+  });
   thread_ = [this] {
     struct inotify_event event = {0};
     int nbytes = read(battery_watch_fd_, &event, sizeof(event));
@@ -92,6 +174,7 @@ void waybar::modules::Battery::refreshBatteries() {
     check_map[bat.first] = false;
   }
 
+  fs::path adapter;
   try {
     for (auto& node : fs::directory_iterator(data_dir_)) {
       if (!fs::is_directory(node)) {
@@ -99,7 +182,10 @@ void waybar::modules::Battery::refreshBatteries() {
       }
       auto dir_name = node.path().filename();
       auto bat_defined = config_["bat"].isString();
-      if (((bat_defined && dir_name == config_["bat"].asString()) || !bat_defined) &&
+      if (batteries_.count(node.path()) != 0) {
+        // Known battery, its attributes have already been probed
+        check_map[node.path()] = true;
+      } else if (((bat_defined && dir_name == config_["bat"].asString()) || !bat_defined) &&
           (fs::exists(node.path() / "capacity") || fs::exists(node.path() / "charge_now")) &&
           fs::exists(node.path() / "uevent") && fs::exists(node.path() / "status") &&
           fs::exists(node.path() / "type")) {
@@ -117,27 +203,32 @@ void waybar::modules::Battery::refreshBatteries() {
           }
 
           check_map[node.path()] = true;
-          auto search = batteries_.find(node.path());
-          if (search == batteries_.end()) {
-            // We've found a new battery save it and start listening for events
+          // We've found a new battery save it and start listening for events
+          int wd = -1;
+          if (battery_watch_fd_ != -1) {
             auto event_path = (node.path() / "uevent");
-            auto wd = inotify_add_watch(battery_watch_fd_, event_path.c_str(), IN_ACCESS);
+            wd = inotify_add_watch(battery_watch_fd_, event_path.c_str(), IN_ACCESS);
             if (wd < 0) {
               throw std::runtime_error("Could not watch events for " + node.path().string());
             }
-            batteries_[node.path()] = wd;
           }
+          batteries_[node.path()] = {wd, std::make_unique<util::SysfsDevice>(node.path())};
         }
       }
       auto adap_defined = config_["adapter"].isString();
       if (((adap_defined && dir_name == config_["adapter"].asString()) || !adap_defined) &&
           (fs::exists(node.path() / "online") || fs::exists(node.path() / "status"))) {
-        adapter_ = node.path();
+        adapter = node.path();
       }
     }
   } catch (fs::filesystem_error& e) {
     throw std::runtime_error(e.what());
   }
+  if (adapter.empty()) {
+    adapter_.reset();
+  } else if (!adapter_ || adapter_->path() != adapter.string()) {
+    adapter_ = std::make_unique<util::SysfsDevice>(adapter);
+  }
   if (warnFirstTime_ && batteries_.empty()) {
     if (config_["bat"].isString()) {
       spdlog::warn("No battery named {0}", config_["bat"].asString());
@@ -151,7 +242,7 @@ void waybar::modules::Battery::refreshBatteries() {
   // Remove any batteries that are no longer present and unwatch them
   for (auto const& check : check_map) {
     if (!check.second) {
-      auto watch_id = batteries_[check.first];
+      auto watch_id = batteries_[check.first].watch;
       if (watch_id >= 0) {
         inotify_rm_watch(battery_watch_fd_, watch_id);
       }
@@ -249,98 +340,57 @@ const std::tuple<uint8_t, float, std::string, float> waybar::modules::Battery::g
 
     std::string status = "Unknown";
     for (auto const& item : batteries_) {
-      auto bat = item.first;
-      std::string _status;
-      std::getline(std::ifstream(bat / "status"), _status);
+      auto& bat = *item.second.attributes;
+      auto read = [&bat](const char* name, uint32_t& value) {
+        auto number = bat.readNumber(name);
+        if (number) {
+          value = *number;
+        }
+        return number.has_value();
+      };
+      std::string _status = bat.readString("status").value_or("");
 
       // Some battery will report current and charge in μA/μAh.
       // Scale these by the voltage to get μW/μWh.
 
       uint32_t capacity = 0;
-      bool capacity_exists = false;
-      if (fs::exists(bat / "capacity")) {
-        capacity_exists = true;
-        std::ifstream(bat / "capacity") >> capacity;
-      }
+      bool capacity_exists = read("capacity", capacity);
 
       uint32_t current_now = 0;
-      bool current_now_exists = false;
-      if (fs::exists(bat / "current_now")) {
-        current_now_exists = true;
-        std::ifstream(bat / "current_now") >> current_now;
-      } else if (fs::exists(bat / "current_avg")) {
-        current_now_exists = true;
-        std::ifstream(bat / "current_avg") >> current_now;
-      }
+      bool current_now_exists =
+          read("current_now", current_now) || read("current_avg", current_now);
 
-      if (fs::exists(bat / "time_to_empty_now")) {
+      if (read("time_to_empty_now", time_to_empty_now)) {
         time_to_empty_now_exists = true;
-        std::ifstream(bat / "time_to_empty_now") >> time_to_empty_now;
       }
-
-      if (fs::exists(bat / "time_to_full_now")) {
+      if (read("time_to_full_now", time_to_full_now)) {
         time_to_full_now_exists = true;
-        std::ifstream(bat / "time_to_full_now") >> time_to_full_now;
       }
 
       uint32_t voltage_now = 0;
-      bool voltage_now_exists = false;
-      if (fs::exists(bat / "voltage_now")) {
-        voltage_now_exists = true;
-        std::ifstream(bat / "voltage_now") >> voltage_now;
-      } else if (fs::exists(bat / "voltage_avg")) {
-        voltage_now_exists = true;
-        std::ifstream(bat / "voltage_avg") >> voltage_now;
-      }
+      bool voltage_now_exists =
+          read("voltage_now", voltage_now) || read("voltage_avg", voltage_now);
 
       uint32_t charge_full = 0;
-      bool charge_full_exists = false;
-      if (fs::exists(bat / "charge_full")) {
-        charge_full_exists = true;
-        std::ifstream(bat / "charge_full") >> charge_full;
-      }
+      bool charge_full_exists = read("charge_full", charge_full);
 
       uint32_t charge_full_design = 0;
-      bool charge_full_design_exists = false;
-      if (fs::exists(bat / "charge_full_design")) {
-        charge_full_design_exists = true;
-        std::ifstream(bat / "charge_full_design") >> charge_full_design;
-      }
+      bool charge_full_design_exists = read("charge_full_design", charge_full_design);
 
       uint32_t charge_now = 0;
-      bool charge_now_exists = false;
-      if (fs::exists(bat / "charge_now")) {
-        charge_now_exists = true;
-        std::ifstream(bat / "charge_now") >> charge_now;
-      }
+      bool charge_now_exists = read("charge_now", charge_now);
 
       uint32_t power_now = 0;
-      bool power_now_exists = false;
-      if (fs::exists(bat / "power_now")) {
-        power_now_exists = true;
-        std::ifstream(bat / "power_now") >> power_now;
-      }
+      bool power_now_exists = read("power_now", power_now);
 
       uint32_t energy_now = 0;
-      bool energy_now_exists = false;
-      if (fs::exists(bat / "energy_now")) {
-        energy_now_exists = true;
-        std::ifstream(bat / "energy_now") >> energy_now;
-      }
+      bool energy_now_exists = read("energy_now", energy_now);
 
       uint32_t energy_full = 0;
-      bool energy_full_exists = false;
-      if (fs::exists(bat / "energy_full")) {
-        energy_full_exists = true;
-        std::ifstream(bat / "energy_full") >> energy_full;
-      }
+      bool energy_full_exists = read("energy_full", energy_full);
 
       uint32_t energy_full_design = 0;
-      bool energy_full_design_exists = false;
-      if (fs::exists(bat / "energy_full_design")) {
-        energy_full_design_exists = true;
-        std::ifstream(bat / "energy_full_design") >> energy_full_design;
-      }
+      bool energy_full_design_exists = read("energy_full_design", energy_full_design);
 
       if (!voltage_now_exists) {
         if (power_now_exists && current_now_exists && current_now != 0) {
@@ -495,11 +545,9 @@ const std::tuple<uint8_t, float, std::string, float> waybar::modules::Battery::g
 
     // Give `Plugged` higher priority over `Not charging`.
     // So in a setting where TLP is used, `Plugged` is shown when the threshold is reached
-    if (!adapter_.empty() && (status == "Discharging" || status == "Not charging")) {
-      bool online;
-      std::string current_status;
-      std::ifstream(adapter_ / "online") >> online;
-      std::getline(std::ifstream(adapter_ / "status"), current_status);
+    if (adapter_ && (status == "Discharging" || status == "Not charging")) {
+      bool online = adapter_->readNumber("online").value_or(0) != 0;
+      std::string current_status = adapter_->readString("status").value_or("");
       if (online && current_status != "Discharging") status = "Plugged";
     }
 
@@ -563,7 +611,7 @@ const std::tuple<uint8_t, float, std::string, float> waybar::modules::Battery::g
   }
 }
 
-const std::string waybar::modules::Battery::getAdapterStatus(uint8_t capacity) const {
+const std::string waybar::modules::Battery::getAdapterStatus(uint8_t capacity) {
 #if defined(__FreeBSD__)
   int state;
   size_t size_state = sizeof state;
@@ -574,11 +622,10 @@ const std::string waybar::modules::Battery::getAdapterStatus(uint8_t capacity) c
   std::string status{"Unknown"};  // TODO: add status in FreeBSD
   {
 #else
-  if (!adapter_.empty()) {
-    bool online;
-    std::string status;
-    std::ifstream(adapter_ / "online") >> online;
-    std::getline(std::ifstream(adapter_ / "status"), status);
+  std::lock_guard<std::mutex> guard(battery_list_mutex_);
+  if (adapter_) {
+    bool online = adapter_->readNumber("online").value_or(0) != 0;
+    std::string status = adapter_->readString("status").value_or("");
 #endif
     if (capacity == 100) {
       return "Full";
@@ -604,8 +651,8 @@ const std::string waybar::modules::Battery::formatTimeRemaining(float hoursRemai
     format = config_["format-time"].asString();
   }
   std::string zero_pad_minutes = fmt::format("{:02d}", minutes);
-  return fmt::format(fmt::runtime(format), fmt::arg("H", full_hours), fmt::arg("M", minutes),
-                     fmt::arg("m", zero_pad_minutes));
+  return formats_.get(format).render(fmt::arg("H", full_hours), fmt::arg("M", minutes),
+                                    fmt::arg("m", zero_pad_minutes));
 }
 
 auto waybar::modules::Battery::update() -> void {
@@ -627,32 +674,35 @@ auto waybar::modules::Battery::update() -> void {
   auto state = getState(capacity, true);
   auto time_remaining_formatted = formatTimeRemaining(time_remaining);
   if (tooltipEnabled()) {
-    std::string tooltip_text_default;
-    std::string tooltip_format = "{timeTo}";
-    if (time_remaining != 0) {
-      std::string time_to = std::string("Time to ") + ((time_remaining > 0) ? "empty" : "full");
-      tooltip_text_default = time_to + ": " + time_remaining_formatted;
-    } else {
-      tooltip_text_default = status_pretty;
-    }
-    if (!state.empty() && config_["tooltip-format-" + status + "-" + state].isString()) {
-      tooltip_format = config_["tooltip-format-" + status + "-" + state].asString();
-    } else if (config_["tooltip-format-" + status].isString()) {
-      tooltip_format = config_["tooltip-format-" + status].asString();
-    } else if (!state.empty() && config_["tooltip-format-" + state].isString()) {
-      tooltip_format = config_["tooltip-format-" + state].asString();
-    } else if (config_["tooltip-format"].isString()) {
-      tooltip_format = config_["tooltip-format"].asString();
-    }
-    label_.set_tooltip_text(fmt::format(fmt::runtime(tooltip_format),
-                                        fmt::arg("timeTo", tooltip_text_default),
-                                        fmt::arg("power", power), fmt::arg("capacity", capacity),
-                                        fmt::arg("time", time_remaining_formatted)));
+    // Structured bindings can't be captured directly
+    setTooltipRenderer([this, capacity = capacity, time_remaining = time_remaining, power = power,
+                        status = status, status_pretty, state, time_remaining_formatted] {
+      std::string tooltip_text_default;
+      std::string tooltip_format = "{timeTo}";
+      if (time_remaining != 0) {
+        std::string time_to = std::string("Time to ") + ((time_remaining > 0) ? "empty" : "full");
+        tooltip_text_default = time_to + ": " + time_remaining_formatted;
+      } else {
+        tooltip_text_default = status_pretty;
+      }
+      if (!state.empty() && config_["tooltip-format-" + status + "-" + state].isString()) {
+        tooltip_format = config_["tooltip-format-" + status + "-" + state].asString();
+      } else if (config_["tooltip-format-" + status].isString()) {
+        tooltip_format = config_["tooltip-format-" + status].asString();
+      } else if (!state.empty() && config_["tooltip-format-" + state].isString()) {
+        tooltip_format = config_["tooltip-format-" + state].asString();
+      } else if (config_["tooltip-format"].isString()) {
+        tooltip_format = config_["tooltip-format"].asString();
+      }
+      return formats_.get(tooltip_format)
+          .render(fmt::arg("timeTo", tooltip_text_default), fmt::arg("power", power),
+                  fmt::arg("capacity", capacity), fmt::arg("time", time_remaining_formatted));
+    });
   }
-  if (!old_status_.empty()) {
-    label_.get_style_context()->remove_class(old_status_);
+  if (old_status_ != status) {
+    setClass(old_status_, false);
   }
-  label_.get_style_context()->add_class(status);
+  setClass(status, true);
   old_status_ = status;
   if (!state.empty() && config_["format-" + status + "-" + state].isString()) {
     format = config_["format-" + status + "-" + state].asString();
@@ -666,9 +716,11 @@ auto waybar::modules::Battery::update() -> void {
   } else {
     event_box_.show();
     auto icons = std::vector<std::string>{status + "-" + state, status, state};
-    label_.set_markup(fmt::format(
-        fmt::runtime(format), fmt::arg("capacity", capacity), fmt::arg("power", power),
-        fmt::arg("icon", getIcon(capacity, icons)), fmt::arg("time", time_remaining_formatted)));
+    const auto& format_template = formats_.get(format);
+    auto icon = format_template.uses("icon") ? getIcon(capacity, icons) : "";
+    setMarkup(format_template.render(fmt::arg("capacity", capacity),
+                                     fmt::arg("power", power), fmt::arg("icon", icon),
+                                     fmt::arg("time", time_remaining_formatted)));
   }
   // Call parent update
   ALabel::update();
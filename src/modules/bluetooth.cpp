@@ -189,23 +189,16 @@ auto waybar::modules::Bluetooth::update() -> void {
 
   format_.empty() ? event_box_.hide() : event_box_.show();
 
-  auto update_style_context = [this](const std::string& style_class, bool in_next_state) {
-    if (in_next_state && !label_.get_style_context()->has_class(style_class)) {
-      label_.get_style_context()->add_class(style_class);
-    } else if (!in_next_state && label_.get_style_context()->has_class(style_class)) {
-      label_.get_style_context()->remove_class(style_class);
-    }
-  };
-  update_style_context("discoverable", cur_controller_.discoverable);
-  update_style_context("discovering", cur_controller_.discovering);
-  update_style_context("pairable", cur_controller_.pairable);
-  if (!state_.empty()) {
-    update_style_context(state_, false);
+  setClass("discoverable", cur_controller_.discoverable);
+  setClass("discovering", cur_controller_.discovering);
+  setClass("pairable", cur_controller_.pairable);
+  if (state_ != state) {
+    setClass(state_, false);
   }
-  update_style_context(state, true);
+  setClass(state, true);
   state_ = state;
 
-  label_.set_markup(fmt::format(
+  setMarkup(fmt::format(
       fmt::runtime(format_), fmt::arg("status", state_),
       fmt::arg("num_connections", connected_devices_.size()),
       fmt::arg("controller_address", cur_controller_.address),
@@ -247,7 +240,7 @@ auto waybar::modules::Bluetooth::update() -> void {
         device_enumerate_.erase(0, 1);
       }
     }
-    label_.set_tooltip_text(fmt::format(
+    setTooltipText(fmt::format(
         fmt::runtime(tooltip_format), fmt::arg("status", state_),
         fmt::arg("num_connections", connected_devices_.size()),
         fmt::arg("controller_address", cur_controller_.address),
@@ -137,14 +137,9 @@ waybar::modules::Clock::Clock(const std::string& id, const Json::Value& config)
   else
     locale_ = std::locale("");
 
-  thread_ = [this] {
-    dp.emit();
-    auto now = std::chrono::system_clock::now();
-    /* difference with projected wakeup time */
-    auto diff = now.time_since_epoch() % interval_;
-    /* sleep until the next projected time */
-    thread_.sleep_for(interval_ - diff);
-  };
+  /* wake up at multiples of the interval */
+  timer_.start(
+      interval_, [this] { dp.emit(); }, true);
 }
 
 const date::time_zone* waybar::modules::Clock::current_timezone() {
@@ -174,23 +169,28 @@ auto waybar::modules::Clock::update() -> void {
   } else {
     text = fmt::format(locale_, fmt::runtime(format_), ztime);
   }
-  label_.set_markup(text);
+  setMarkup(text);
 
   if (tooltipEnabled()) {
     if (config_["tooltip-format"].isString()) {
-      std::string calendar_lines{""};
-      std::string timezoned_time_lines{""};
-      if (is_calendar_in_tooltip_) {
-        calendar_lines = get_calendar(ztime, shifted_ztime);
-      }
-      if (is_timezoned_list_in_tooltip_) {
-        timezoned_time_lines = timezones_text(&now);
-      }
-      auto tooltip_format = config_["tooltip-format"].asString();
-      text = fmt::format(locale_, fmt::runtime(tooltip_format), shifted_ztime,
-                         fmt::arg(kCalendarPlaceholder.c_str(), calendar_lines),
-                         fmt::arg(KTimezonedTimeListPlaceholder.c_str(), timezoned_time_lines));
-      label_.set_tooltip_markup(text);
+      // The calendar is only built when hovered
+      setTooltipRenderer(
+          [this, now, ztime, shifted_ztime]() mutable {
+            std::string calendar_lines{""};
+            std::string timezoned_time_lines{""};
+            if (is_calendar_in_tooltip_) {
+              calendar_lines = get_calendar(ztime, shifted_ztime);
+            }
+            if (is_timezoned_list_in_tooltip_) {
+              timezoned_time_lines = timezones_text(&now);
+            }
+            auto tooltip_format = config_["tooltip-format"].asString();
+            return fmt::format(
+                locale_, fmt::runtime(tooltip_format), shifted_ztime,
+                fmt::arg(kCalendarPlaceholder.c_str(), calendar_lines),
+                fmt::arg(KTimezonedTimeListPlaceholder.c_str(), timezoned_time_lines));
+          },
+          true);
     }
   }
 
@@ -320,17 +320,15 @@ auto waybar::modules::Clock::get_calendar(const date::zoned_seconds& now,
   daypoint = date::floor<date::days>(now.get_local_time());
   const auto currDate{date::year_month_day{daypoint}};
 
-  if (cldMode_ == CldMode::YEAR) {
-    if (y / date::month{1} / 1 == cldYearShift_)
-      return cldYearCached_;
-    else
-      cldYearShift_ = y / date::month{1} / 1;
+  // The highlighted day is the only thing changing over time, start over at midnight. Weeks
+  // position, formats and locale are fixed by the config.
+  if (currDate != cldCacheDay_) {
+    cldCache_.clear();
+    cldCacheDay_ = currDate;
   }
-  if (cldMode_ == CldMode::MONTH) {
-    if (ym == cldMonShift_)
-      return cldMonCached_;
-    else
-      cldMonShift_ = ym;
+  const auto cacheKey{std::make_pair(cldMode_, (cldMode_ == CldMode::YEAR) ? y / 1 : ym)};
+  if (auto cached = cldCache_.find(cacheKey); cached != cldCache_.end()) {
+    return cached->second;
   }
 
   // Compute number of lines needed for each calendar month
@@ -404,12 +402,9 @@ auto waybar::modules::Clock::get_calendar(const date::zoned_seconds& now,
       // Apply today format
       fmt::arg("today", fmt::format(fmt::runtime(fmtMap_[3]), date::format("%e", ymd.day()))));
 
-  if (cldMode_ == CldMode::YEAR)
-    cldYearCached_ = os.str();
-  else
-    cldMonCached_ = os.str();
-
-  return os.str();
+  // Only meant for scrolling back and forth, don't grow forever when scrolling away
+  if (cldCache_.size() >= 24) cldCache_.clear();
+  return cldCache_.emplace(cacheKey, os.str()).first->second;
 }
 
 /*Clock actions*/
@@ -9,22 +9,97 @@
 #include <fmt/core.h>
 #endif
 
+#include <algorithm>
+#include <iterator>
+
+namespace {
+
+/* Block elements used for the history sparklines, from the lowest to the highest usage */
+constexpr const char* SPARKLINE_GLYPHS[] = {"▁", "▂", "▃", "▄", "▅", "▆", "▇", "█"};
+constexpr size_t SPARKLINE_LEVELS = std::size(SPARKLINE_GLYPHS);
+
+}  // namespace
+
 waybar::modules::Cpu::Cpu(const std::string& id, const Json::Value& config)
-    : ALabel(config, "cpu", id, "{usage}%", 10) {
-  thread_ = [this] {
-    dp.emit();
-    thread_.sleep_for(interval_);
+    : ALabel(config, "cpu", id, "{usage}%", 10),
+      history_(config["history-length"].isUInt() ? config["history-length"].asUInt() : 20) {
+  if (config_["graph"].isBool() && config_["graph"].asBool()) {
+    event_box_.remove();
+    box_.set_orientation(Gtk::Orientation::ORIENTATION_HORIZONTAL);
+    box_.set_spacing(4);
+    box_.add(label_);
+    box_.add(graph_);
+    event_box_.add(box_);
+    graph_.get_style_context()->add_class("graph");
+    graph_.set_size_request(config_["graph-width"].isUInt() ? config_["graph-width"].asUInt() : 40,
+                            -1);
+    graph_.signal_draw().connect(sigc::mem_fun(*this, &Cpu::handleGraphDraw));
+  }
+  // Reading the frequencies is only worth it when one of the formats shows them
+  bool frequency = false;
+  for (const auto& name : config_.getMemberNames()) {
+    if (name.rfind("format", 0) != 0 || name == "format-icons" || !config_[name].isString()) {
+      continue;
+    }
+    try {
+      const auto& format = formats_.get(config_[name].asString());
+      frequency = frequency || format.uses("max_frequency") || format.uses("min_frequency") ||
+                  format.uses("avg_frequency");
+    } catch (const fmt::format_error&) {
+      // Reported when the format is used
+    }
+  }
+  auto take_sample = [frequency, prev_times = std::vector<std::tuple<size_t, size_t>>(),
+                      curr_times = std::vector<std::tuple<size_t, size_t>>()]() mutable {
+    Sample sample{};
+    sample.load = getCpuLoad();
+    sample.usage = getCpuUsage(prev_times, curr_times);
+    if (frequency) {
+      std::tie(sample.max_frequency, sample.min_frequency, sample.avg_frequency) =
+          getCpuFrequency();
+    }
+    return sample;
   };
+  // The usage is computed from the times of the previous call, the first one only reads them
+  sampler_ =
+      util::Sampler<Sample>::get(fmt::format("cpu:{}:{}", interval_.count(), frequency),
+                                 interval_, std::move(take_sample), true);
+  sampler_conn_ = sampler_->signal_sample.connect([this] { dp.emit(); });
+  // Another bar may have sampled already
+  dp.emit();
 }
 
+waybar::modules::Cpu::~Cpu() { sampler_conn_.disconnect(); }
+
 auto waybar::modules::Cpu::update() -> void {
-  // TODO: as creating dynamic fmt::arg arrays is buggy we have to calc both
-  auto cpu_load = getCpuLoad();
-  auto [cpu_usage, tooltip] = getCpuUsage();
-  auto [max_frequency, min_frequency, avg_frequency] = getCpuFrequency();
-  if (tooltipEnabled()) {
-    label_.set_tooltip_text(tooltip);
+  auto sample = sampler_->latest();
+  if (!sample) {
+    return;
+  }
+  // update() also runs on clicks, only record each sample once
+  if (sample != last_sample_) {
+    last_sample_ = sample;
+    pushHistory(sample->usage);
+    if (tooltipEnabled()) {
+      setTooltipRenderer([this] {
+        const auto& usage = last_sample_->usage;
+        std::string tooltip;
+        for (size_t i = 0; i < usage.size(); ++i) {
+          if (i == 0) {
+            tooltip = fmt::format("Total: {}%", usage[i]);
+          } else {
+            tooltip += fmt::format("\nCore{}: {}%", i - 1, usage[i]);
+          }
+        }
+        return tooltip;
+      });
+    }
   }
+  auto cpu_load = sample->load;
+  const auto& cpu_usage = sample->usage;
+  auto max_frequency = sample->max_frequency;
+  auto min_frequency = sample->min_frequency;
+  auto avg_frequency = sample->avg_frequency;
   auto format = format_;
   auto total_usage = cpu_usage.empty() ? 0 : cpu_usage[0];
   auto state = getState(total_usage);
@@ -37,27 +112,72 @@ auto waybar::modules::Cpu::update() -> void {
   } else {
     event_box_.show();
     auto icons = std::vector<std::string>{state};
+    const auto& format_template = formats_.get(format);
     fmt::dynamic_format_arg_store<fmt::format_context> store;
     store.push_back(fmt::arg("load", cpu_load));
     store.push_back(fmt::arg("usage", total_usage));
-    store.push_back(fmt::arg("icon", getIcon(total_usage, icons)));
+    store.push_back(
+        fmt::arg("icon", format_template.uses("icon") ? getIcon(total_usage, icons) : ""));
     store.push_back(fmt::arg("max_frequency", max_frequency));
     store.push_back(fmt::arg("min_frequency", min_frequency));
     store.push_back(fmt::arg("avg_frequency", avg_frequency));
+    store.push_back(fmt::arg("history", sparklines_.empty() ? "" : sparklines_[0]));
     for (size_t i = 1; i < cpu_usage.size(); ++i) {
       auto core_i = i - 1;
       auto core_format = fmt::format("usage{}", core_i);
       store.push_back(fmt::arg(core_format.c_str(), cpu_usage[i]));
       auto icon_format = fmt::format("icon{}", core_i);
-      store.push_back(fmt::arg(icon_format.c_str(), getIcon(cpu_usage[i], icons)));
+      store.push_back(fmt::arg(icon_format.c_str(), format_template.uses(icon_format)
+                                                        ? getIcon(cpu_usage[i], icons)
+                                                        : ""));
+      auto history_format = fmt::format("history{}", core_i);
+      store.push_back(
+          fmt::arg(history_format.c_str(), i < sparklines_.size() ? sparklines_[i] : ""));
     }
-    label_.set_markup(fmt::vformat(format, store));
+    setMarkup(format_template.vrender(store));
   }
 
   // Call parent update
   ALabel::update();
 }
 
+void waybar::modules::Cpu::pushHistory(const std::vector<uint16_t>& usage) {
+  if (usage.size() != history_.series()) {
+    sparklines_.assign(usage.size(), "");
+  }
+  history_.push(usage);
+  // Only the newest column changes: drop the oldest glyph and append one for the new sample
+  for (size_t i = 0; i < usage.size(); ++i) {
+    auto& sparkline = sparklines_[i];
+    auto glyph = SPARKLINE_GLYPHS[std::min<size_t>(
+        history_.back(i) * SPARKLINE_LEVELS / 101, SPARKLINE_LEVELS - 1)];
+    auto glyph_len = std::char_traits<char>::length(glyph);
+    if (sparkline.size() >= history_.capacity() * glyph_len) {
+      sparkline.erase(0, glyph_len);
+    }
+    sparkline.append(glyph);
+  }
+  if (graph_.get_parent() != nullptr) {
+    graph_.queue_draw();
+  }
+}
+
+bool waybar::modules::Cpu::handleGraphDraw(const Cairo::RefPtr<Cairo::Context>& cr) {
+  auto width = graph_.get_allocated_width();
+  auto height = graph_.get_allocated_height();
+  auto color = graph_.get_style_context()->get_color(graph_.get_state_flags());
+  cr->set_source_rgba(color.get_red(), color.get_green(), color.get_blue(), color.get_alpha());
+  // Total usage, the newest sample on the right
+  auto count = history_.series() > 0 ? history_.size() : 0;
+  double column = static_cast<double>(width) / history_.capacity();
+  for (size_t i = 0; i < count; ++i) {
+    double value = history_.at(0, i) / 100.0;
+    cr->rectangle(width - (count - i) * column, height * (1 - value), column, height * value);
+  }
+  cr->fill();
+  return true;
+}
+
 double waybar::modules::Cpu::getCpuLoad() {
   double load[1];
   if (getloadavg(load, 1) != -1) {
@@ -66,29 +186,28 @@ double waybar::modules::Cpu::getCpuLoad() {
   throw std::runtime_error("Can't get Cpu load");
 }
 
-std::tuple<std::vector<uint16_t>, std::string> waybar::modules::Cpu::getCpuUsage() {
-  if (prev_times_.empty()) {
-    prev_times_ = parseCpuinfo();
-    std::this_thread::sleep_for(std::chrono::milliseconds(100));
-  }
-  std::vector<std::tuple<size_t, size_t>> curr_times = parseCpuinfo();
-  std::string tooltip;
+std::vector<uint16_t> waybar::modules::Cpu::getCpuUsage(
+    std::vector<std::tuple<size_t, size_t>>& prev_times,
+    std::vector<std::tuple<size_t, size_t>>& curr_times) {
+  parseCpuinfo(curr_times);
   std::vector<uint16_t> usage;
-  for (size_t i = 0; i < curr_times.size(); ++i) {
+  usage.reserve(curr_times.size());
+  // The number of cores may change between samples with CPU hotplug
+  for (size_t i = 0; i < std::min(curr_times.size(), prev_times.size()); ++i) {
     auto [curr_idle, curr_total] = curr_times[i];
-    auto [prev_idle, prev_total] = prev_times_[i];
+    auto [prev_idle, prev_total] = prev_times[i];
     const float delta_idle = curr_idle - prev_idle;
     const float delta_total = curr_total - prev_total;
-    uint16_t tmp = 100 * (1 - delta_idle / delta_total);
-    if (i == 0) {
-      tooltip = fmt::format("Total: {}%", tmp);
-    } else {
-      tooltip = tooltip + fmt::format("\nCore{}: {}%", i - 1, tmp);
+    if (delta_total <= 0) {
+      // No time accounted since the previous sample
+      usage.push_back(0);
+      continue;
     }
+    uint16_t tmp = 100 * (1 - delta_idle / delta_total);
     usage.push_back(tmp);
   }
-  prev_times_ = curr_times;
-  return {usage, tooltip};
+  std::swap(prev_times, curr_times);
+  return usage;
 }
 
 std::tuple<float, float, float> waybar::modules::Cpu::getCpuFrequency() {
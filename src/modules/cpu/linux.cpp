@@ -1,42 +1,283 @@
-#include <filesystem>
+#include <dirent.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <cstring>
+#include <optional>
 
 #include "modules/cpu.hpp"
 
-std::vector<std::tuple<size_t, size_t>> waybar::modules::Cpu::parseCpuinfo() {
-  const std::string data_dir_ = "/proc/stat";
-  std::ifstream info(data_dir_);
-  if (!info.is_open()) {
-    throw std::runtime_error("Can't open " + data_dir_);
+namespace {
+
+/* Parse a decimal number without allocating, leaving `p` after its last digit */
+size_t scanNumber(const char*& p, const char* end) {
+  size_t value = 0;
+  for (; p < end && *p >= '0' && *p <= '9'; ++p) {
+    value = value * 10 + (*p - '0');
   }
-  std::vector<std::tuple<size_t, size_t>> cpuinfo;
-  std::string line;
-  while (getline(info, line)) {
-    if (line.substr(0, 3).compare("cpu") != 0) {
-      break;
+  return value;
+}
+
+/*
+ * Parse the leading "cpu" lines of /proc/stat into `cpuinfo`, reusing its storage.
+ * Returns false if the buffer ends before the last cpu line does.
+ */
+bool parseProcStat(const char* p, const char* end, bool eof,
+                   std::vector<std::tuple<size_t, size_t>>& cpuinfo) {
+  size_t n = 0;
+  while (end - p >= 3 && std::memcmp(p, "cpu", 3) == 0) {
+    auto eol = static_cast<const char*>(std::memchr(p, '\n', end - p));
+    if (eol == nullptr) {
+      if (!eof) {
+        return false;
+      }
+      eol = end;
     }
-    std::stringstream sline(line.substr(5));
-    std::vector<size_t> times;
-    for (size_t time = 0; sline >> time; times.push_back(time))
+    // skip the "cpu" or "cpuN" label
+    for (p += 3; p < eol && *p != ' '; ++p)
       ;
-
     size_t idle_time = 0;
     size_t total_time = 0;
-    if (times.size() >= 4) {
-      idle_time = times[3];
-      total_time = std::accumulate(times.begin(), times.end(), 0);
+    size_t fields = 0;
+    while (p < eol) {
+      if (*p < '0' || *p > '9') {
+        ++p;
+        continue;
+      }
+      auto time = scanNumber(p, eol);
+      if (fields == 3) {
+        idle_time = time;
+      }
+      total_time += time;
+      ++fields;
+    }
+    if (fields < 4) {
+      idle_time = 0;
+      total_time = 0;
+    }
+    if (n < cpuinfo.size()) {
+      cpuinfo[n] = {idle_time, total_time};
+    } else {
+      cpuinfo.emplace_back(idle_time, total_time);
+    }
+    ++n;
+    p = eol + 1;
+  }
+  // A truncated read may end in the middle of the "cpu" prefix
+  if (!eof && end - p < 3) {
+    return false;
+  }
+  cpuinfo.resize(n);
+  return true;
+}
+
+/* A cpufreq policy: a group of cpus sharing their frequency */
+struct CpufreqPolicy {
+  int cur_freq_fd;
+  // -1 if the kernel doesn't list the cpus of the policy, it is then counted as a single cpu
+  int affected_cpus_fd;
+  // Online cpus of the policy, as of its last read of affected_cpus
+  size_t cpus;
+};
+
+/* Read a small sysfs attribute from an open fd, returns false with errno set on error */
+bool readAttribute(int fd, std::array<char, 64>& buffer, size_t& value) {
+  auto len = pread(fd, buffer.data(), buffer.size(), 0);
+  if (len <= 0) {
+    if (len == 0) {
+      errno = EIO;
     }
-    cpuinfo.emplace_back(idle_time, total_time);
+    return false;
+  }
+  const char* p = buffer.data();
+  value = scanNumber(p, p + len);
+  return true;
+}
+
+/* Number of cpus listed in a cpulist such as "0-3 8 10-11" */
+size_t countCpus(const char* p, const char* end) {
+  size_t count = 0;
+  while (p < end) {
+    if (*p < '0' || *p > '9') {
+      ++p;
+      continue;
+    }
+    auto first = scanNumber(p, end);
+    auto last = first;
+    if (p < end && *p == '-') {
+      ++p;
+      last = scanNumber(p, end);
+    }
+    count += last >= first ? last - first + 1 : 1;
+  }
+  return count;
+}
+
+/* Number of online cpus of a policy, from its affected_cpus fd. Returns false on error. */
+bool readAffectedCpus(int fd, size_t& cpus) {
+  if (fd == -1) {
+    cpus = 1;
+    return true;
+  }
+  char buffer[4096];
+  auto len = pread(fd, buffer, sizeof(buffer), 0);
+  if (len < 0) {
+    return false;
+  }
+  // Empty once all the cpus of the policy are offline
+  cpus = countCpus(buffer, buffer + len);
+  return true;
+}
+
+/* The policy or the cpus it belongs to are gone, e.g. with cpu hotplug */
+bool isGone(int error) { return error == ENOENT || error == ENODEV; }
+
+void closeCpufreqPolicies(const std::vector<CpufreqPolicy>& policies) {
+  for (const auto& policy : policies) {
+    close(policy.cur_freq_fd);
+    if (policy.affected_cpus_fd != -1) {
+      close(policy.affected_cpus_fd);
+    }
+  }
+}
+
+/*
+ * Open scaling_cur_freq and affected_cpus of every cpufreq policy. Policies are discovered once:
+ * the files are then read through the kept fds instead of walking sysfs on every sample.
+ */
+std::vector<CpufreqPolicy> openCpufreqPolicies() {
+  std::vector<CpufreqPolicy> policies;
+  int dir_fd = open("/sys/devices/system/cpu/cpufreq", O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+  if (dir_fd == -1) {
+    return policies;
+  }
+  // fdopendir takes ownership of its fd, keep dir_fd for openat
+  DIR* dir = fdopendir(dup(dir_fd));
+  if (dir == nullptr) {
+    close(dir_fd);
+    return policies;
+  }
+  std::vector<std::pair<size_t, std::string>> names;
+  while (auto* entry = readdir(dir)) {
+    const char* p = entry->d_name;
+    if (std::strncmp(p, "policy", 6) != 0) {
+      continue;
+    }
+    p += 6;
+    names.emplace_back(scanNumber(p, p + std::strlen(p)), entry->d_name);
+  }
+  closedir(dir);
+  std::sort(names.begin(), names.end());
+
+  for (const auto& [index, name] : names) {
+    int fd = openat(dir_fd, (name + "/scaling_cur_freq").c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd == -1) {
+      continue;
+    }
+    int cpus_fd = openat(dir_fd, (name + "/affected_cpus").c_str(), O_RDONLY | O_CLOEXEC);
+    size_t cpus = 0;
+    if (!readAffectedCpus(cpus_fd, cpus)) {
+      close(cpus_fd);
+      cpus_fd = -1;
+      cpus = 1;
+    }
+    policies.push_back({fd, cpus_fd, cpus});
+  }
+  close(dir_fd);
+  return policies;
+}
+
+}  // namespace
+
+void waybar::modules::Cpu::parseCpuinfo(std::vector<std::tuple<size_t, size_t>>& cpuinfo) {
+  const std::string data_dir_ = "/proc/stat";
+  // Kept open and reused between calls, samples are only taken on the scheduler thread
+  static int fd = -1;
+  static std::vector<char> buffer(16384);
+  if (fd == -1) {
+    fd = open(data_dir_.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd == -1) {
+      throw std::runtime_error("Can't open " + data_dir_);
+    }
+  }
+  while (true) {
+    auto len = pread(fd, buffer.data(), buffer.size(), 0);
+    if (len < 0) {
+      throw std::runtime_error("Can't read " + data_dir_);
+    }
+    bool eof = static_cast<size_t>(len) < buffer.size();
+    if (parseProcStat(buffer.data(), buffer.data() + len, eof, cpuinfo)) {
+      return;
+    }
+    // Many cores: the cpu lines don't fit in the buffer
+    buffer.resize(buffer.size() * 2);
   }
-  return cpuinfo;
 }
 
 std::vector<float> waybar::modules::Cpu::parseCpuFrequencies() {
+  // Discovered on the first sample, samples are only taken on the scheduler thread
+  static std::optional<std::vector<CpufreqPolicy>> policies;
+  if (!policies) {
+    policies = openCpufreqPolicies();
+  }
+
+  std::vector<float> frequencies;
+  std::array<char, 64> buffer;
+  bool rediscover = false;
+  for (const auto& policy : *policies) {
+    size_t cpus;
+    if (!readAffectedCpus(policy.affected_cpus_fd, cpus)) {
+      rediscover = isGone(errno);
+      if (rediscover) {
+        break;
+      }
+      continue;
+    }
+    if (cpus != policy.cpus) {
+      // cpus went online or offline, the policies may have been regrouped
+      rediscover = true;
+      break;
+    }
+    if (cpus == 0) {
+      continue;
+    }
+    size_t khz;
+    if (!readAttribute(policy.cur_freq_fd, buffer, khz)) {
+      // Only a policy that went away is discovered again. Others (e.g. EBUSY while its cpus are
+      // going offline) are left out of this sample.
+      rediscover = isGone(errno);
+      if (rediscover) {
+        break;
+      }
+      continue;
+    }
+    // One value per cpu, so that the average stays weighted by core
+    frequencies.insert(frequencies.end(), cpus, khz / 1000.f);
+  }
+  if (rediscover) {
+    closeCpufreqPolicies(*policies);
+    policies = openCpufreqPolicies();
+    frequencies.clear();
+    for (const auto& policy : *policies) {
+      size_t khz;
+      if (policy.cpus > 0 && readAttribute(policy.cur_freq_fd, buffer, khz)) {
+        frequencies.insert(frequencies.end(), policy.cpus, khz / 1000.f);
+      }
+    }
+  }
+  if (!frequencies.empty()) {
+    return frequencies;
+  }
+
+  // No cpufreq support (e.g. in virtual machines)
   const std::string file_path_ = "/proc/cpuinfo";
   std::ifstream info(file_path_);
   if (!info.is_open()) {
     throw std::runtime_error("Can't open " + file_path_);
   }
-  std::vector<float> frequencies;
   std::string line;
   while (getline(info, line)) {
     if (line.substr(0, 7).compare("cpu MHz") != 0) {
@@ -49,27 +290,5 @@ std::vector<float> waybar::modules::Cpu::parseCpuFrequencies() {
   }
   info.close();
 
-  if (frequencies.size() <= 0) {
-    std::string cpufreq_dir = "/sys/devices/system/cpu/cpufreq";
-    if (std::filesystem::exists(cpufreq_dir)) {
-      std::vector<std::string> frequency_files = {"/cpuinfo_min_freq", "/cpuinfo_max_freq"};
-      for (auto& p : std::filesystem::directory_iterator(cpufreq_dir)) {
-        for (auto freq_file : frequency_files) {
-          std::string freq_file_path = p.path().string() + freq_file;
-          if (std::filesystem::exists(freq_file_path)) {
-            std::string freq_value;
-            std::ifstream freq(freq_file_path);
-            if (freq.is_open()) {
-              getline(freq, freq_value);
-              float frequency = std::strtol(freq_value.c_str(), nullptr, 10);
-              frequencies.push_back(frequency / 1000);
-              freq.close();
-            }
-          }
-        }
-      }
-    }
-  }
-
   return frequencies;
 }
@@ -2,6 +2,8 @@
 
 #include <spdlog/spdlog.h>
 
+#include <algorithm>
+
 waybar::modules::Custom::Custom(const std::string& name, const std::string& id,
                                 const Json::Value& config)
     : ALabel(config, "custom-" + name, id, "{}"),
@@ -132,28 +134,32 @@ auto waybar::modules::Custom::update() -> void {
     if (str.empty()) {
       event_box_.hide();
     } else {
-      label_.set_markup(str);
+      setMarkup(str);
       if (tooltipEnabled()) {
         if (text_ == tooltip_) {
           if (label_.get_tooltip_markup() != str) {
-            label_.set_tooltip_markup(str);
+            setTooltipMarkup(str);
           }
         } else {
           if (label_.get_tooltip_markup() != tooltip_) {
-            label_.set_tooltip_markup(tooltip_);
+            setTooltipMarkup(tooltip_);
           }
         }
       }
-      auto classes = label_.get_style_context()->list_classes();
-      for (auto const& c : classes) {
-        if (c == id_) continue;
-        label_.get_style_context()->remove_class(c);
+      // Only the classes that changed since the previous output are touched
+      for (auto const& c : applied_class_) {
+        if (c != id_ && std::find(class_.begin(), class_.end(), c) == class_.end()) {
+          setClass(c, false);
+        }
       }
       for (auto const& c : class_) {
-        label_.get_style_context()->add_class(c);
+        if (c != id_) {
+          setClass(c, true);
+        }
       }
-      label_.get_style_context()->add_class("flat");
-      label_.get_style_context()->add_class("text-button");
+      applied_class_ = class_;
+      setClass("flat", true);
+      setClass("text-button", true);
       event_box_.show();
     }
   }
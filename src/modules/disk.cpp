@@ -4,17 +4,27 @@ using namespace waybar::util;
 
 waybar::modules::Disk::Disk(const std::string& id, const Json::Value& config)
     : ALabel(config, "disk", id, "{}%", 30), path_("/") {
-  thread_ = [this] {
-    dp.emit();
-    thread_.sleep_for(interval_);
-  };
   if (config["path"].isString()) {
     path_ = config["path"].asString();
   }
+  sampler_ = util::Sampler<sample_t>::get(
+      fmt::format("disk:{}:{}", interval_.count(), path_), interval_, [path = path_]() {
+        struct statvfs stats;
+        return statvfs(path.c_str(), &stats) == 0 ? sample_t(stats) : std::nullopt;
+      });
+  sampler_conn_ = sampler_->signal_sample.connect([this] { dp.emit(); });
+  // Another bar may have sampled already
+  dp.emit();
 }
 
+waybar::modules::Disk::~Disk() { sampler_conn_.disconnect(); }
+
 auto waybar::modules::Disk::update() -> void {
-  struct statvfs /* {
+  auto sample = sampler_->latest();
+  if (!sample) {
+    return;
+  }
+  /* struct statvfs {
       unsigned long  f_bsize;    // filesystem block size
       unsigned long  f_frsize;   // fragment size
       fsblkcnt_t     f_blocks;   // size of fs in f_frsize units
@@ -27,8 +37,6 @@ auto waybar::modules::Disk::update() -> void {
       unsigned long  f_flag;     // mount flags
       unsigned long  f_namemax;  // maximum filename length
   }; */
-      stats;
-  int err = statvfs(path_.c_str(), &stats);
 
   /* Conky options
     fs_bar - Bar that shows how much space is used
@@ -38,10 +46,11 @@ auto waybar::modules::Disk::update() -> void {
     fs_used - File system used space
   */
 
-  if (err != 0) {
+  if (!sample->has_value()) {
     event_box_.hide();
     return;
   }
+  const auto& stats = **sample;
 
   auto free = pow_format(stats.f_bavail * stats.f_frsize, "B", true);
   auto used = pow_format((stats.f_blocks - stats.f_bfree) * stats.f_frsize, "B", true);
@@ -58,23 +67,25 @@ auto waybar::modules::Disk::update() -> void {
     event_box_.hide();
   } else {
     event_box_.show();
-    label_.set_markup(fmt::format(
-        fmt::runtime(format), stats.f_bavail * 100 / stats.f_blocks, fmt::arg("free", free),
+    setMarkup(formats_.get(format).render(
+        stats.f_bavail * 100 / stats.f_blocks, fmt::arg("free", free),
         fmt::arg("percentage_free", stats.f_bavail * 100 / stats.f_blocks), fmt::arg("used", used),
         fmt::arg("percentage_used", percentage_used), fmt::arg("total", total),
         fmt::arg("path", path_)));
   }
 
   if (tooltipEnabled()) {
-    std::string tooltip_format = "{used} used out of {total} on {path} ({percentage_used}%)";
-    if (config_["tooltip-format"].isString()) {
-      tooltip_format = config_["tooltip-format"].asString();
-    }
-    label_.set_tooltip_text(fmt::format(
-        fmt::runtime(tooltip_format), stats.f_bavail * 100 / stats.f_blocks, fmt::arg("free", free),
-        fmt::arg("percentage_free", stats.f_bavail * 100 / stats.f_blocks), fmt::arg("used", used),
-        fmt::arg("percentage_used", percentage_used), fmt::arg("total", total),
-        fmt::arg("path", path_)));
+    setTooltipRenderer([this, stats, free, used, total, percentage_used] {
+      std::string tooltip_format = "{used} used out of {total} on {path} ({percentage_used}%)";
+      if (config_["tooltip-format"].isString()) {
+        tooltip_format = config_["tooltip-format"].asString();
+      }
+      return formats_.get(tooltip_format)
+          .render(stats.f_bavail * 100 / stats.f_blocks, fmt::arg("free", free),
+                  fmt::arg("percentage_free", stats.f_bavail * 100 / stats.f_blocks),
+                  fmt::arg("used", used), fmt::arg("percentage_used", percentage_used),
+                  fmt::arg("total", total), fmt::arg("path", path_));
+    });
   }
   // Call parent update
   ALabel::update();
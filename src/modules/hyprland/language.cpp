@@ -39,7 +39,7 @@ auto Language::update() -> void {
 
   if (!format_.empty()) {
     label_.show();
-    label_.set_markup(layoutName_);
+    setMarkup(layoutName_);
   } else {
     label_.hide();
   }
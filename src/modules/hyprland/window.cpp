@@ -13,7 +13,7 @@
 namespace waybar::modules::hyprland {
 
 Window::Window(const std::string& id, const Bar& bar, const Json::Value& config)
-    : ALabel(config, "window", id, "{}", 0, true), bar_(bar) {
+    : ALabel(config, "window", id, "{}", 0, true), bar_(bar), rewrite_rules_(config["rewrite"]) {
   modulesReady = true;
   separate_outputs = config["separate-outputs"].as<bool>();
 
@@ -40,8 +40,7 @@ auto Window::update() -> void {
 
   if (!format_.empty()) {
     label_.show();
-    label_.set_markup(fmt::format(fmt::runtime(format_),
-                                  waybar::util::rewriteTitle(lastView, config_["rewrite"])));
+    setMarkup(fmt::format(fmt::runtime(format_), rewrite_rules_.apply(lastView)));
   } else {
     label_.hide();
   }
@@ -27,23 +27,18 @@ waybar::modules::Image::Image(const std::string& id, const Json::Value& config)
 }
 
 void waybar::modules::Image::delayWorker() {
-  thread_ = [this] {
-    dp.emit();
-    auto interval = std::chrono::seconds(interval_);
-    thread_.sleep_for(interval);
-  };
+  timer_.start(std::chrono::seconds(interval_), [this] { dp.emit(); });
 }
 
 void waybar::modules::Image::refresh(int sig) {
   if (sig == SIGRTMIN + config_["signal"].asInt()) {
-    thread_.wake_up();
+    timer_.wake_up();
   }
 }
 
 auto waybar::modules::Image::update() -> void {
   util::command::res output_;
 
-  Glib::RefPtr<Gdk::Pixbuf> pixbuf;
   if (config_["path"].isString()) {
     path_ = config_["path"].asString();
   } else if (config_["exec"].isString()) {
@@ -52,18 +47,23 @@ auto waybar::modules::Image::update() -> void {
   } else {
     path_ = "";
   }
-  if (Glib::file_test(path_, Glib::FILE_TEST_EXISTS))
-    pixbuf = Gdk::Pixbuf::create_from_file(path_, size_, size_);
-  else
-    pixbuf = {};
-
-  if (pixbuf) {
-    image_.set(pixbuf);
-    image_.show();
-  } else {
-    image_.clear();
-    image_.hide();
-  }
+  // Decoded on a worker, the previous image is shown in the meantime
+  request_.start(
+      [path = path_, size = size_]() -> Glib::RefPtr<Gdk::Pixbuf> {
+        if (!Glib::file_test(path, Glib::FILE_TEST_EXISTS)) {
+          return {};
+        }
+        return Gdk::Pixbuf::create_from_file(path, size, size);
+      },
+      [this](Glib::RefPtr<Gdk::Pixbuf> pixbuf) {
+        if (pixbuf) {
+          image_.set(pixbuf);
+          image_.show();
+        } else {
+          image_.clear();
+          image_.hide();
+        }
+      });
 
   AModule::update();
 }
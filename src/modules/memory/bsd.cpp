@@ -79,7 +79,11 @@ static uint64_t get_free_memory() {
 #endif
 }
 
-void waybar::modules::Memory::parseMeminfo() {
-  meminfo_["MemTotal"] = get_total_memory() / 1024;
-  meminfo_["MemAvailable"] = get_free_memory() / 1024;
+// Swap is not read on BSD, the swap fields stay unset
+waybar::modules::Memory::meminfo_t waybar::modules::Memory::parseMeminfo(
+    [[maybe_unused]] bool swap) {
+  meminfo_t meminfo;
+  meminfo.set(MemTotal, get_total_memory() / 1024);
+  meminfo.set(MemAvailable, get_free_memory() / 1024);
+  return meminfo;
 }
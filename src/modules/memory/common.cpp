@@ -2,32 +2,41 @@
 
 waybar::modules::Memory::Memory(const std::string& id, const Json::Value& config)
     : ALabel(config, "memory", id, "{}%", 30) {
-  thread_ = [this] {
-    dp.emit();
-    thread_.sleep_for(interval_);
-  };
+  // Swap usage is only needed when one of the formats shows it
+  bool swap = false;
+  for (const auto& name : config_.getMemberNames()) {
+    if ((name.rfind("format", 0) == 0 || name == "tooltip-format") && config_[name].isString() &&
+        config_[name].asString().find("{swap") != std::string::npos) {
+      swap = true;
+    }
+  }
+  sampler_ = util::Sampler<meminfo_t>::get(fmt::format("memory:{}:{}", interval_.count(), swap),
+                                           interval_, [swap] { return parseMeminfo(swap); });
+  sampler_conn_ = sampler_->signal_sample.connect([this] { dp.emit(); });
+  // Another bar may have sampled already
+  dp.emit();
 }
 
-auto waybar::modules::Memory::update() -> void {
-  parseMeminfo();
+waybar::modules::Memory::~Memory() { sampler_conn_.disconnect(); }
 
-  unsigned long memtotal = meminfo_["MemTotal"];
-  unsigned long swaptotal = 0;
-  if (meminfo_.count("SwapTotal")) {
-    swaptotal = meminfo_["SwapTotal"];
+auto waybar::modules::Memory::update() -> void {
+  auto sample = sampler_->latest();
+  if (!sample) {
+    return;
   }
+  const auto& meminfo = *sample;
+
+  unsigned long memtotal = meminfo[MemTotal];
+  unsigned long swaptotal = meminfo[SwapTotal];
   unsigned long memfree;
-  unsigned long swapfree = 0;
-  if (meminfo_.count("SwapFree")) {
-    swapfree = meminfo_["SwapFree"];
-  }
-  if (meminfo_.count("MemAvailable")) {
+  unsigned long swapfree = meminfo[SwapFree];
+  if (meminfo.present[MemAvailable]) {
     // New kernels (3.4+) have an accurate available memory field.
-    memfree = meminfo_["MemAvailable"] + meminfo_["zfs_size"];
+    memfree = meminfo[MemAvailable] + meminfo[ZfsSize];
   } else {
     // Old kernel; give a best-effort approximation of available memory.
-    memfree = meminfo_["MemFree"] + meminfo_["Buffers"] + meminfo_["Cached"] +
-              meminfo_["SReclaimable"] - meminfo_["Shmem"] + meminfo_["zfs_size"];
+    memfree = meminfo[MemFree] + meminfo[Buffers] + meminfo[Cached] + meminfo[SReclaimable] -
+              meminfo[Shmem] + meminfo[ZfsSize];
   }
 
   if (memtotal > 0 && memfree >= 0) {
@@ -55,11 +64,11 @@ auto waybar::modules::Memory::update() -> void {
     } else {
       event_box_.show();
       auto icons = std::vector<std::string>{state};
-      label_.set_markup(fmt::format(
-          fmt::runtime(format), used_ram_percentage,
-          fmt::arg("icon", getIcon(used_ram_percentage, icons)),
-          fmt::arg("total", total_ram_gigabytes), fmt::arg("swapTotal", total_swap_gigabytes),
-          fmt::arg("percentage", used_ram_percentage),
+      const auto& format_template = formats_.get(format);
+      auto icon = format_template.uses("icon") ? getIcon(used_ram_percentage, icons) : "";
+      setMarkup(format_template.render(
+          used_ram_percentage, fmt::arg("icon", icon), fmt::arg("total", total_ram_gigabytes),
+          fmt::arg("swapTotal", total_swap_gigabytes), fmt::arg("percentage", used_ram_percentage),
           fmt::arg("swapPercentage", used_swap_percentage), fmt::arg("used", used_ram_gigabytes),
           fmt::arg("swapUsed", used_swap_gigabytes), fmt::arg("avail", available_ram_gigabytes),
           fmt::arg("swapAvail", available_swap_gigabytes)));
@@ -68,15 +77,15 @@ auto waybar::modules::Memory::update() -> void {
     if (tooltipEnabled()) {
       if (config_["tooltip-format"].isString()) {
         auto tooltip_format = config_["tooltip-format"].asString();
-        label_.set_tooltip_text(fmt::format(
-            fmt::runtime(tooltip_format), used_ram_percentage,
-            fmt::arg("total", total_ram_gigabytes), fmt::arg("swapTotal", total_swap_gigabytes),
+        setTooltipText(formats_.get(tooltip_format).render(
+            used_ram_percentage, fmt::arg("total", total_ram_gigabytes),
+            fmt::arg("swapTotal", total_swap_gigabytes),
             fmt::arg("percentage", used_ram_percentage),
             fmt::arg("swapPercentage", used_swap_percentage), fmt::arg("used", used_ram_gigabytes),
             fmt::arg("swapUsed", used_swap_gigabytes), fmt::arg("avail", available_ram_gigabytes),
             fmt::arg("swapAvail", available_swap_gigabytes)));
       } else {
-        label_.set_tooltip_text(fmt::format("{:.{}f}GiB used", used_ram_gigabytes, 1));
+        setTooltipText(fmt::format("{:.{}f}GiB used", used_ram_gigabytes, 1));
       }
     }
   } else {
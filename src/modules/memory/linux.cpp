@@ -1,43 +1,130 @@
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <cstring>
+#include <string_view>
+
 #include "modules/memory.hpp"
 
-static unsigned zfsArcSize() {
-  std::ifstream zfs_arc_stats{"/proc/spl/kstat/zfs/arcstats"};
+namespace {
 
-  if (zfs_arc_stats.is_open()) {
-    std::string name;
-    std::string type;
-    unsigned long data{0};
+using waybar::modules::Memory;
 
-    std::string line;
-    while (std::getline(zfs_arc_stats, line)) {
-      std::stringstream(line) >> name >> type >> data;
+/* /proc/meminfo keys of each field, in the order of Memory::Field */
+constexpr std::array<std::string_view, Memory::ZfsSize> MEMINFO_KEYS = {
+    "MemTotal", "MemFree", "MemAvailable", "Buffers", "Cached",
+    "SReclaimable", "Shmem", "SwapTotal", "SwapFree",
+};
+static_assert(MEMINFO_KEYS.back() == "SwapFree", "MEMINFO_KEYS must follow Memory::Field");
 
-      if (name == "size") {
-        return data / 1024;  // convert to kB
-      }
+/* Field of a /proc/meminfo key, FieldCount for keys the module does not use */
+constexpr Memory::Field fieldOf(std::string_view key) {
+  for (size_t i = 0; i < MEMINFO_KEYS.size(); ++i) {
+    if (MEMINFO_KEYS[i] == key) {
+      return static_cast<Memory::Field>(i);
     }
   }
+  return Memory::FieldCount;
+}
+static_assert(fieldOf("SReclaimable") == Memory::SReclaimable);
+static_assert(fieldOf("Active") == Memory::FieldCount);
 
-  return 0;
+/* Parse a decimal number after optional spaces without allocating */
+unsigned long scanNumber(const char* p, const char* end) {
+  for (; p < end && *p == ' '; ++p)
+    ;
+  unsigned long value = 0;
+  for (; p < end && *p >= '0' && *p <= '9'; ++p) {
+    value = value * 10 + (*p - '0');
+  }
+  return value;
 }
 
-void waybar::modules::Memory::parseMeminfo() {
-  const std::string data_dir_ = "/proc/meminfo";
-  std::ifstream info(data_dir_);
-  if (!info.is_open()) {
-    throw std::runtime_error("Can't open " + data_dir_);
-  }
-  std::string line;
-  while (getline(info, line)) {
-    auto posDelim = line.find(':');
-    if (posDelim == std::string::npos) {
-      continue;
+/*
+ * Read `path` into `buffer` through a descriptor kept open between calls.
+ * Returns the length read, or -1 if the file can't be opened or read.
+ */
+ssize_t readCached(const char* path, int& fd, std::vector<char>& buffer) {
+  if (fd == -1) {
+    fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd == -1) {
+      return -1;
+    }
+  }
+  return pread(fd, buffer.data(), buffer.size(), 0);
+}
+
+/* Size of the ZFS ARC in kB, 0 without ZFS */
+unsigned long zfsArcSize() {
+  // Kept open and reused between calls, samples are only taken on the scheduler thread
+  static int fd = -1;
+  static std::vector<char> buffer(16384);
+  auto len = readCached("/proc/spl/kstat/zfs/arcstats", fd, buffer);
+  if (len <= 0) {
+    return 0;
+  }
+  // Lines are "name type data", "size" is one of the first entries
+  const char* end = buffer.data() + len;
+  for (const char* p = buffer.data(); p < end;) {
+    auto eol = static_cast<const char*>(std::memchr(p, '\n', end - p));
+    if (eol == nullptr) {
+      eol = end;
+    }
+    if (eol - p > 5 && std::memcmp(p, "size ", 5) == 0) {
+      // skip the name and the type
+      for (int column = 0; column < 2 && p < eol; ++p) {
+        if (*p == ' ' && p + 1 < eol && p[1] != ' ') {
+          ++column;
+        }
+      }
+      return scanNumber(p, eol) / 1024;  // convert to kB
     }
+    p = eol + 1;
+  }
+  return 0;
+}
+
+}  // namespace
+
+waybar::modules::Memory::meminfo_t waybar::modules::Memory::parseMeminfo(bool swap) {
+  const char* data_dir_ = "/proc/meminfo";
+  static int fd = -1;
+  static std::vector<char> buffer(8192);
+  auto len = readCached(data_dir_, fd, buffer);
+  if (len < 0) {
+    throw std::runtime_error(std::string("Can't open ") + data_dir_);
+  }
+
+  // Stop reading as soon as all the needed fields have been found
+  std::bitset<FieldCount> wanted;
+  wanted.set(MemTotal).set(MemAvailable);
+  wanted.set(MemFree).set(Buffers).set(Cached).set(SReclaimable).set(Shmem);
+  if (swap) {
+    wanted.set(SwapTotal).set(SwapFree);
+  }
 
-    std::string name = line.substr(0, posDelim);
-    int64_t value = std::stol(line.substr(posDelim + 1));
-    meminfo_[name] = value;
+  meminfo_t meminfo;
+  const char* end = buffer.data() + len;
+  for (const char* p = buffer.data(); p < end && wanted.any();) {
+    auto eol = static_cast<const char*>(std::memchr(p, '\n', end - p));
+    if (eol == nullptr) {
+      eol = end;
+    }
+    auto colon = static_cast<const char*>(std::memchr(p, ':', eol - p));
+    if (colon != nullptr) {
+      auto field = fieldOf(std::string_view(p, colon - p));
+      if (field != FieldCount && wanted[field]) {
+        meminfo.set(field, scanNumber(colon + 1, eol));
+        wanted.reset(field);
+        if (field == MemAvailable) {
+          // Only needed to approximate the available memory on old kernels
+          wanted.reset(MemFree).reset(Buffers).reset(Cached).reset(SReclaimable).reset(Shmem);
+        }
+      }
+    }
+    p = eol + 1;
   }
 
-  meminfo_["zfs_size"] = zfsArcSize();
+  meminfo.set(ZfsSize, zfsArcSize());
+  return meminfo;
 }
@@ -5,6 +5,7 @@
 #include <string>
 
 #include "modules/mpris/mpris.hpp"
+#include "util/text_width.hpp"
 
 extern "C" {
 #include <playerctl/playerctl.h>
@@ -147,10 +148,7 @@ Mpris::Mpris(const std::string& id, const Json::Value& config)
 
   // allow setting an interval count that triggers periodic refreshes
   if (interval_.count() > 0) {
-    thread_ = [this] {
-      dp.emit();
-      thread_.sleep_for(interval_);
-    };
+    timer_.start(interval_, [this] { dp.emit(); });
   }
 
   // trigger initial update
@@ -173,72 +171,21 @@ auto Mpris::getIconFromJson(const Json::Value& icons, const std::string& key) ->
   return "";
 }
 
-// Wide characters count as two, zero-width characters count as zero
-// Modifies str in-place (unless width = std::string::npos)
-// Returns the total width of the string pre-truncating
-size_t utf8_truncate(std::string& str, size_t width = std::string::npos) {
-  if (str.length() == 0) return 0;
-
-  const gchar* trunc_end = nullptr;
-
-  size_t total_width = 0;
-
-  for (gchar *data = str.data(), *end = data + str.size(); data;) {
-    gunichar c = g_utf8_get_char_validated(data, end - data);
-    if (c == -1 || c == -2) {
-      // invalid unicode, treat string as ascii
-      if (width != std::string::npos && str.length() > width) str.resize(width);
-      return str.length();
-    } else if (g_unichar_iswide(c)) {
-      total_width += 2;
-    } else if (!g_unichar_iszerowidth(c) && c != 0xAD) {  // neither zero-width nor soft hyphen
-      total_width += 1;
-    }
-
-    data = g_utf8_find_next_char(data, end);
-    if (width != std::string::npos && total_width <= width && !g_unichar_isspace(c))
-      trunc_end = data;
-  }
-
-  if (trunc_end) str.resize(trunc_end - str.data());
-
-  return total_width;
-}
-
-size_t utf8_width(const std::string& str) { return utf8_truncate(const_cast<std::string&>(str)); }
-
-void truncate(std::string& s, const std::string& ellipsis, size_t max_len) {
-  if (max_len == 0) {
-    s.resize(0);
-    return;
-  }
-  size_t len = utf8_truncate(s, max_len);
-  if (len > max_len) {
-    size_t ellipsis_len = utf8_width(ellipsis);
-    if (max_len >= ellipsis_len) {
-      if (ellipsis_len) utf8_truncate(s, max_len - ellipsis_len);
-      s += ellipsis;
-    } else {
-      s.resize(0);
-    }
-  }
-}
-
 auto Mpris::getArtistStr(const PlayerInfo& info, bool truncated) -> std::string {
   auto artist = info.artist.value_or(std::string());
-  if (truncated && artist_len_ >= 0) truncate(artist, ellipsis_, artist_len_);
+  if (truncated && artist_len_ >= 0) artist = util::truncateText(artist, artist_len_, ellipsis_);
   return artist;
 }
 
 auto Mpris::getAlbumStr(const PlayerInfo& info, bool truncated) -> std::string {
   auto album = info.album.value_or(std::string());
-  if (truncated && album_len_ >= 0) truncate(album, ellipsis_, album_len_);
+  if (truncated && album_len_ >= 0) album = util::truncateText(album, album_len_, ellipsis_);
   return album;
 }
 
 auto Mpris::getTitleStr(const PlayerInfo& info, bool truncated) -> std::string {
   auto title = info.title.value_or(std::string());
-  if (truncated && title_len_ >= 0) truncate(title, ellipsis_, title_len_);
+  if (truncated && title_len_ >= 0) title = util::truncateText(title, title_len_, ellipsis_);
   return title;
 }
 
@@ -266,9 +213,9 @@ auto Mpris::getDynamicStr(const PlayerInfo& info, bool truncated, bool html) ->
   // keep position format same as length format
   auto position = getPositionStr(info, truncated && truncate_hours_ && length.length() < 6);
 
-  size_t artistLen = utf8_width(artist);
-  size_t albumLen = utf8_width(album);
-  size_t titleLen = utf8_width(title);
+  size_t artistLen = util::textWidth(artist);
+  size_t albumLen = util::textWidth(album);
+  size_t titleLen = util::textWidth(title);
   size_t lengthLen = length.length();
   size_t posLen = position.length();
 
@@ -614,34 +561,48 @@ auto Mpris::update() -> void {
       (tooltip_len_limits_ || position.length() > 5) ? position : getPositionStr(info, false);
 
   try {
-    auto label_format = fmt::format(
-        fmt::runtime(formatstr), fmt::arg("player", info.name),
-        fmt::arg("status", info.status_string), fmt::arg("artist", getArtistStr(info, true)),
-        fmt::arg("title", getTitleStr(info, true)), fmt::arg("album", getAlbumStr(info, true)),
+    // Only the fields shown by the format are computed
+    const auto& format = formats_.get(formatstr);
+    auto label_format = format.render(
+        fmt::arg("player", info.name), fmt::arg("status", info.status_string),
+        fmt::arg("artist", format.uses("artist") ? getArtistStr(info, true) : ""),
+        fmt::arg("title", format.uses("title") ? getTitleStr(info, true) : ""),
+        fmt::arg("album", format.uses("album") ? getAlbumStr(info, true) : ""),
         fmt::arg("length", length), fmt::arg("position", position),
-        fmt::arg("dynamic", getDynamicStr(info, true, true)),
-        fmt::arg("player_icon", getIconFromJson(config_["player-icons"], info.name)),
-        fmt::arg("status_icon", getIconFromJson(config_["status-icons"], info.status_string)));
-
-    label_.set_markup(label_format);
+        fmt::arg("dynamic", format.uses("dynamic") ? getDynamicStr(info, true, true) : ""),
+        fmt::arg("player_icon", format.uses("player_icon")
+                                    ? getIconFromJson(config_["player-icons"], info.name)
+                                    : ""),
+        fmt::arg("status_icon", format.uses("status_icon")
+                                    ? getIconFromJson(config_["status-icons"], info.status_string)
+                                    : ""));
+
+    setMarkup(label_format);
   } catch (fmt::format_error const& e) {
     spdlog::warn("mpris: format error: {}", e.what());
   }
 
   if (tooltipEnabled()) {
     try {
-      auto tooltip_text = fmt::format(
-          fmt::runtime(tooltipstr), fmt::arg("player", info.name),
-          fmt::arg("status", info.status_string),
-          fmt::arg("artist", getArtistStr(info, tooltip_len_limits_)),
-          fmt::arg("title", getTitleStr(info, tooltip_len_limits_)),
-          fmt::arg("album", getAlbumStr(info, tooltip_len_limits_)),
+      const auto& format = formats_.get(tooltipstr);
+      auto tooltip_text = format.render(
+          fmt::arg("player", info.name), fmt::arg("status", info.status_string),
+          fmt::arg("artist", format.uses("artist") ? getArtistStr(info, tooltip_len_limits_) : ""),
+          fmt::arg("title", format.uses("title") ? getTitleStr(info, tooltip_len_limits_) : ""),
+          fmt::arg("album", format.uses("album") ? getAlbumStr(info, tooltip_len_limits_) : ""),
           fmt::arg("length", tooltipLength), fmt::arg("position", tooltipPosition),
-          fmt::arg("dynamic", getDynamicStr(info, tooltip_len_limits_, false)),
-          fmt::arg("player_icon", getIconFromJson(config_["player-icons"], info.name)),
-          fmt::arg("status_icon", getIconFromJson(config_["status-icons"], info.status_string)));
-
-      label_.set_tooltip_text(tooltip_text);
+          fmt::arg("dynamic", format.uses("dynamic")
+                                  ? getDynamicStr(info, tooltip_len_limits_, false)
+                                  : ""),
+          fmt::arg("player_icon", format.uses("player_icon")
+                                      ? getIconFromJson(config_["player-icons"], info.name)
+                                      : ""),
+          fmt::arg("status_icon",
+                   format.uses("status_icon")
+                       ? getIconFromJson(config_["status-icons"], info.status_string)
+                       : ""));
+
+      setTooltipText(tooltip_text);
     } catch (fmt::format_error const& e) {
       spdlog::warn("mpris: format error (tooltip): {}", e.what());
     }
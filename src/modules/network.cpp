@@ -1,13 +1,15 @@
 #include "modules/network.hpp"
 
 #include <linux/if.h>
+#include <linux/if_link.h>
+#include <linux/rtnetlink.h>
 #include <spdlog/spdlog.h>
 #include <sys/eventfd.h>
+#include <sys/socket.h>
 
 #include <cassert>
-#include <fstream>
+#include <cstring>
 #include <optional>
-#include <sstream>
 
 #include "util/format.hpp"
 #ifdef WANT_RFKILL
@@ -19,62 +21,63 @@ using namespace waybar::util;
 constexpr const char *DEFAULT_FORMAT = "{ifname}";
 }  // namespace
 
-constexpr const char *NETDEV_FILE =
-    "/proc/net/dev";  // std::ifstream does not take std::string_view as param
 std::optional<std::pair<unsigned long long, unsigned long long>>
 waybar::modules::Network::readBandwidthUsage() {
-  std::ifstream netdev(NETDEV_FILE);
-  if (!netdev) {
-    spdlog::warn("Failed to open netdev file {}", NETDEV_FILE);
+  if (stats_fd_ < 0 || ifid_ <= 0) {
     return {};
   }
 
-  std::string line;
-  // skip the headers (first two lines)
-  std::getline(netdev, line);
-  std::getline(netdev, line);
-
-  unsigned long long receivedBytes = 0ull;
-  unsigned long long transmittedBytes = 0ull;
-  while (std::getline(netdev, line)) {
-    std::istringstream iss(line);
+  // Ask the kernel for the counters of our interface only
+  struct {
+    struct nlmsghdr nh;
+    struct ifinfomsg ifi;
+  } req{};
+  req.nh.nlmsg_len = NLMSG_LENGTH(sizeof(req.ifi));
+  req.nh.nlmsg_type = RTM_GETLINK;
+  req.nh.nlmsg_flags = NLM_F_REQUEST;
+  req.nh.nlmsg_seq = ++stats_seq_;
+  req.ifi.ifi_family = AF_UNSPEC;
+  req.ifi.ifi_index = ifid_;
+  if (send(stats_fd_, &req, req.nh.nlmsg_len, 0) < 0) {
+    spdlog::warn("network: can't request link statistics: {}", strerror(errno));
+    return {};
+  }
 
-    std::string ifacename;
-    iss >> ifacename;      // ifacename contains "eth0:"
-    ifacename.pop_back();  // remove trailing ':'
-    if (ifacename != ifname_) {
-      continue;
+  // RTM_GETLINK is handled synchronously, the reply is queued once send() returns
+  while (true) {
+    auto len = recv(stats_fd_, stats_buffer_.data(), stats_buffer_.size(), MSG_DONTWAIT);
+    if (len < 0) {
+      return {};
     }
-
-    // The rest of the line consists of whitespace separated counts divided
-    // into two groups (receive and transmit). Each group has the following
-    // columns: bytes, packets, errs, drop, fifo, frame, compressed, multicast
-    //
-    // We only care about the bytes count, so we'll just ignore the 7 other
-    // columns.
-    unsigned long long r = 0ull;
-    unsigned long long t = 0ull;
-    // Read received bytes
-    iss >> r;
-    // Skip all the other columns in the received group
-    for (int colsToSkip = 7; colsToSkip > 0; colsToSkip--) {
-      // skip whitespace between columns
-      while (iss.peek() == ' ') {
-        iss.ignore();
+    auto nh = reinterpret_cast<struct nlmsghdr *>(stats_buffer_.data());
+    for (; NLMSG_OK(nh, len); nh = NLMSG_NEXT(nh, len)) {
+      if (nh->nlmsg_seq != stats_seq_) {
+        // Left over from an earlier request
+        continue;
       }
-      // skip the irrelevant column
-      while (iss.peek() != ' ') {
-        iss.ignore();
+      if (nh->nlmsg_type != RTM_NEWLINK) {
+        // e.g. NLMSG_ERROR if the interface has just been removed
+        return {};
       }
+      auto ifi = static_cast<struct ifinfomsg *>(NLMSG_DATA(nh));
+      ssize_t attrlen = IFLA_PAYLOAD(nh);
+      std::optional<std::pair<unsigned long long, unsigned long long>> bandwidth;
+      for (auto ifla = IFLA_RTA(ifi); RTA_OK(ifla, attrlen); ifla = RTA_NEXT(ifla, attrlen)) {
+        if (ifla->rta_type == IFLA_STATS64 && RTA_PAYLOAD(ifla) >= sizeof(rtnl_link_stats64)) {
+          // Attributes are only 4-byte aligned
+          struct rtnl_link_stats64 stats;
+          memcpy(&stats, RTA_DATA(ifla), sizeof(stats));
+          return {{stats.rx_bytes, stats.tx_bytes}};
+        }
+        if (ifla->rta_type == IFLA_STATS && RTA_PAYLOAD(ifla) >= sizeof(rtnl_link_stats)) {
+          struct rtnl_link_stats stats;
+          memcpy(&stats, RTA_DATA(ifla), sizeof(stats));
+          bandwidth = {stats.rx_bytes, stats.tx_bytes};
+        }
+      }
+      return bandwidth;
     }
-    // Read transmit bytes
-    iss >> t;
-
-    receivedBytes += r;
-    transmittedBytes += t;
   }
-
-  return {{receivedBytes, transmittedBytes}};
 }
 
 waybar::modules::Network::Network(const std::string &id, const Json::Value &config)
@@ -99,16 +102,10 @@ waybar::modules::Network::Network(const std::string &id, const Json::Value &conf
   // update it. Since the text should be different, update() will be able
   // to show or hide the event_box_. This is to work around the case where
   // the module start with no text, but the event_box_ is shown.
-  label_.set_markup("<s></s>");
+  setMarkup("<s></s>");
 
-  auto bandwidth = readBandwidthUsage();
-  if (bandwidth.has_value()) {
-    bandwidth_down_total_ = (*bandwidth).first;
-    bandwidth_up_total_ = (*bandwidth).second;
-  } else {
-    bandwidth_down_total_ = 0;
-    bandwidth_up_total_ = 0;
-  }
+  bandwidth_down_total_ = 0;
+  bandwidth_up_total_ = 0;
 
   if (!config_["interface"].isString()) {
     // "interface" isn't configured, then try to guess the external
@@ -123,6 +120,7 @@ waybar::modules::Network::Network(const std::string &id, const Json::Value &conf
 
   createEventSocket();
   createInfoSocket();
+  createStatsSocket();
 
   dp.emit();
   // Ask for a dump of interfaces and then addresses to populate our
@@ -133,6 +131,10 @@ waybar::modules::Network::Network(const std::string &id, const Json::Value &conf
 }
 
 waybar::modules::Network::~Network() {
+  // The info thread uses the netlink sockets below, wait for it to be done with them
+  timer_.stop();
+  thread_info_.stop();
+  { std::lock_guard<std::mutex> lock(mutex_); }
   if (ev_fd_ > -1) {
     close(ev_fd_);
   }
@@ -153,6 +155,9 @@ waybar::modules::Network::~Network() {
     nl_close(sock_);
     nl_socket_free(sock_);
   }
+  if (stats_fd_ > -1) {
+    close(stats_fd_);
+  }
 }
 
 void waybar::modules::Network::createEventSocket() {
@@ -222,25 +227,44 @@ void waybar::modules::Network::createInfoSocket() {
   }
 }
 
+void waybar::modules::Network::createStatsSocket() {
+  // Separate from ev_sock_, so that the replies don't end up in the event thread
+  stats_fd_ = socket(AF_NETLINK, SOCK_RAW | SOCK_CLOEXEC, NETLINK_ROUTE);
+  if (stats_fd_ < 0) {
+    spdlog::warn("network: can't create socket for link statistics");
+    return;
+  }
+  struct sockaddr_nl addr = {};
+  addr.nl_family = AF_NETLINK;
+  if (bind(stats_fd_, reinterpret_cast<struct sockaddr *>(&addr), sizeof(addr)) < 0) {
+    spdlog::warn("network: can't bind socket for link statistics");
+    close(stats_fd_);
+    stats_fd_ = -1;
+  }
+}
+
 void waybar::modules::Network::worker() {
   // update via here not working
-  thread_timer_ = [this] {
+  // getInfo() waits for nl80211 replies and mutex_ may be held for seconds (see below), which
+  // would hold up the timers of every module: the shared timer only wakes a thread of our own
+  thread_info_ = [this] {
     {
       std::lock_guard<std::mutex> lock(mutex_);
-      if (ifid_ > 0) {
+      if (ifid_ > 0 && thread_info_.isRunning()) {
         getInfo();
         dp.emit();
       }
     }
-    thread_timer_.sleep_for(interval_);
+    thread_info_.sleep_until(std::chrono::system_clock::time_point::max());
   };
+  timer_.start(interval_, [this] { thread_info_.wake_up(); });
 #ifdef WANT_RFKILL
   rfkill_.on_update.connect([this](auto &) {
     /* If we are here, it's likely that the network thread already holds the mutex and will be
      * holding it for a next few seconds.
-     * Let's delegate the update to the timer thread instead of blocking the main thread.
+     * Let's delegate the update to the info thread instead of blocking the main thread.
      */
-    thread_timer_.wake_up();
+    thread_info_.wake_up();
   });
 #else
   spdlog::warn("Waybar has been built without rfkill support.");
@@ -309,8 +333,8 @@ auto waybar::modules::Network::update() -> void {
 
   if (!alt_) {
     auto state = getNetworkState();
-    if (!state_.empty() && label_.get_style_context()->has_class(state_)) {
-      label_.get_style_context()->remove_class(state_);
+    if (state_ != state) {
+      setClass(state_, false);
     }
     if (config_["format-" + state].isString()) {
       default_format_ = config_["format-" + state].asString();
@@ -322,21 +346,21 @@ auto waybar::modules::Network::update() -> void {
     if (config_["tooltip-format-" + state].isString()) {
       tooltip_format = config_["tooltip-format-" + state].asString();
     }
-    if (!label_.get_style_context()->has_class(state)) {
-      label_.get_style_context()->add_class(state);
-    }
+    setClass(state, true);
     format_ = default_format_;
     state_ = state;
   }
   getState(signal_strength_);
 
-  auto text = fmt::format(
-      fmt::runtime(format_), fmt::arg("essid", essid_), fmt::arg("signaldBm", signal_strength_dbm_),
+  const auto& format_template = formats_.get(format_);
+  auto icon = format_template.uses("icon") ? getIcon(signal_strength_, state_) : "";
+  auto text = format_template.render(
+      fmt::arg("essid", essid_), fmt::arg("signaldBm", signal_strength_dbm_),
       fmt::arg("signalStrength", signal_strength_),
       fmt::arg("signalStrengthApp", signal_strength_app_), fmt::arg("ifname", ifname_),
       fmt::arg("netmask", netmask_), fmt::arg("ipaddr", ipaddr_), fmt::arg("gwaddr", gwaddr_),
       fmt::arg("cidr", cidr_), fmt::arg("frequency", fmt::format("{:.1f}", frequency_)),
-      fmt::arg("icon", getIcon(signal_strength_, state_)),
+      fmt::arg("icon", icon),
       fmt::arg("bandwidthDownBits", pow_format(bandwidth_down * 8ull / interval_.count(), "b/s")),
       fmt::arg("bandwidthUpBits", pow_format(bandwidth_up * 8ull / interval_.count(), "b/s")),
       fmt::arg("bandwidthTotalBits",
@@ -349,44 +373,45 @@ auto waybar::modules::Network::update() -> void {
       fmt::arg("bandwidthUpBytes", pow_format(bandwidth_up / interval_.count(), "B/s")),
       fmt::arg("bandwidthTotalBytes",
                pow_format((bandwidth_up + bandwidth_down) / interval_.count(), "B/s")));
-  if (text.compare(label_.get_label()) != 0) {
-    label_.set_markup(text);
-    if (text.empty()) {
-      event_box_.hide();
-    } else {
-      event_box_.show();
-    }
+  setMarkup(text);
+  if (text.empty()) {
+    event_box_.hide();
+  } else {
+    event_box_.show();
   }
   if (tooltipEnabled()) {
     if (tooltip_format.empty() && config_["tooltip-format"].isString()) {
       tooltip_format = config_["tooltip-format"].asString();
     }
     if (!tooltip_format.empty()) {
-      auto tooltip_text = fmt::format(
-          fmt::runtime(tooltip_format), fmt::arg("essid", essid_),
-          fmt::arg("signaldBm", signal_strength_dbm_), fmt::arg("signalStrength", signal_strength_),
-          fmt::arg("signalStrengthApp", signal_strength_app_), fmt::arg("ifname", ifname_),
-          fmt::arg("netmask", netmask_), fmt::arg("ipaddr", ipaddr_), fmt::arg("gwaddr", gwaddr_),
-          fmt::arg("cidr", cidr_), fmt::arg("frequency", fmt::format("{:.1f}", frequency_)),
-          fmt::arg("icon", getIcon(signal_strength_, state_)),
-          fmt::arg("bandwidthDownBits",
-                   pow_format(bandwidth_down * 8ull / interval_.count(), "b/s")),
-          fmt::arg("bandwidthUpBits", pow_format(bandwidth_up * 8ull / interval_.count(), "b/s")),
-          fmt::arg("bandwidthTotalBits",
-                   pow_format((bandwidth_up + bandwidth_down) * 8ull / interval_.count(), "b/s")),
-          fmt::arg("bandwidthDownOctets", pow_format(bandwidth_down / interval_.count(), "o/s")),
-          fmt::arg("bandwidthUpOctets", pow_format(bandwidth_up / interval_.count(), "o/s")),
-          fmt::arg("bandwidthTotalOctets",
-                   pow_format((bandwidth_up + bandwidth_down) / interval_.count(), "o/s")),
-          fmt::arg("bandwidthDownBytes", pow_format(bandwidth_down / interval_.count(), "B/s")),
-          fmt::arg("bandwidthUpBytes", pow_format(bandwidth_up / interval_.count(), "B/s")),
-          fmt::arg("bandwidthTotalBytes",
-                   pow_format((bandwidth_up + bandwidth_down) / interval_.count(), "B/s")));
-      if (label_.get_tooltip_text() != tooltip_text) {
-        label_.set_tooltip_markup(tooltip_text);
-      }
-    } else if (label_.get_tooltip_text() != text) {
-      label_.set_tooltip_markup(text);
+      auto render = [this, tooltip_format, bandwidth_down, bandwidth_up] {
+        // Rendered from the main loop, outside of update()
+        std::lock_guard<std::mutex> lock(mutex_);
+        return formats_.get(tooltip_format).render(
+            fmt::arg("essid", essid_), fmt::arg("signaldBm", signal_strength_dbm_),
+            fmt::arg("signalStrength", signal_strength_),
+            fmt::arg("signalStrengthApp", signal_strength_app_), fmt::arg("ifname", ifname_),
+            fmt::arg("netmask", netmask_), fmt::arg("ipaddr", ipaddr_),
+            fmt::arg("gwaddr", gwaddr_), fmt::arg("cidr", cidr_),
+            fmt::arg("frequency", fmt::format("{:.1f}", frequency_)),
+            fmt::arg("icon", getIcon(signal_strength_, state_)),
+            fmt::arg("bandwidthDownBits",
+                     pow_format(bandwidth_down * 8ull / interval_.count(), "b/s")),
+            fmt::arg("bandwidthUpBits", pow_format(bandwidth_up * 8ull / interval_.count(), "b/s")),
+            fmt::arg("bandwidthTotalBits",
+                     pow_format((bandwidth_up + bandwidth_down) * 8ull / interval_.count(), "b/s")),
+            fmt::arg("bandwidthDownOctets", pow_format(bandwidth_down / interval_.count(), "o/s")),
+            fmt::arg("bandwidthUpOctets", pow_format(bandwidth_up / interval_.count(), "o/s")),
+            fmt::arg("bandwidthTotalOctets",
+                     pow_format((bandwidth_up + bandwidth_down) / interval_.count(), "o/s")),
+            fmt::arg("bandwidthDownBytes", pow_format(bandwidth_down / interval_.count(), "B/s")),
+            fmt::arg("bandwidthUpBytes", pow_format(bandwidth_up / interval_.count(), "B/s")),
+            fmt::arg("bandwidthTotalBytes",
+                     pow_format((bandwidth_up + bandwidth_down) / interval_.count(), "B/s")));
+      };
+      setTooltipRenderer(render, true);
+    } else {
+      setTooltipMarkup(text);
     }
   }
 
@@ -474,7 +499,7 @@ int waybar::modules::Network::handleEvents(struct nl_msg *msg, void *data) {
           if (net->carrier_ != *carrier) {
             if (*carrier) {
               // Ask for WiFi information
-              net->thread_timer_.wake_up();
+              net->thread_info_.wake_up();
             } else {
               // clear state related to WiFi connection
               net->essid_.clear();
@@ -497,7 +522,7 @@ int waybar::modules::Network::handleEvents(struct nl_msg *msg, void *data) {
           if (carrier.has_value()) {
             net->carrier_ = carrier.value();
           }
-          net->thread_timer_.wake_up();
+          net->thread_info_.wake_up();
           /* An address for this new interface should be received via an
            * RTM_NEWADDR event either because we ask for a dump of both links
            * and addrs, or because this interface has just been created and
@@ -680,7 +705,7 @@ int waybar::modules::Network::handleEvents(struct nl_msg *msg, void *data) {
            * addresses. */
           net->want_addr_dump_ = true;
           net->askForStateDump();
-          net->thread_timer_.wake_up();
+          net->thread_info_.wake_up();
         } else if (is_del_event && temp_idx == net->ifid_ && net->route_priority == priority) {
           spdlog::debug("network: default route deleted {}/if{} metric {}", net->ifname_, temp_idx,
                         priority);
@@ -263,9 +263,9 @@ auto waybar::modules::Pulseaudio::update() -> void {
         monitor_.find("a2dp-sink") != std::string::npos ||  // PipeWire
         monitor_.find("bluez") != std::string::npos) {
       format_name = format_name + "-bluetooth";
-      label_.get_style_context()->add_class("bluetooth");
+      setClass("bluetooth", true);
     } else {
-      label_.get_style_context()->remove_class("bluetooth");
+      setClass("bluetooth", false);
     }
     if (muted_) {
       // Check muted bluetooth format exist, otherwise fallback to default muted format
@@ -273,23 +273,23 @@ auto waybar::modules::Pulseaudio::update() -> void {
         format_name = "format";
       }
       format_name = format_name + "-muted";
-      label_.get_style_context()->add_class("muted");
-      label_.get_style_context()->add_class("sink-muted");
+      setClass("muted", true);
+      setClass("sink-muted", true);
     } else {
-      label_.get_style_context()->remove_class("muted");
-      label_.get_style_context()->remove_class("sink-muted");
+      setClass("muted", false);
+      setClass("sink-muted", false);
     }
     format = config_[format_name].isString() ? config_[format_name].asString() : format;
   }
   // TODO: find a better way to split source/sink
   std::string format_source = "{volume}%";
   if (source_muted_) {
-    label_.get_style_context()->add_class("source-muted");
+    setClass("source-muted", true);
     if (config_["format-source-muted"].isString()) {
       format_source = config_["format-source-muted"].asString();
     }
   } else {
-    label_.get_style_context()->remove_class("source-muted");
+    setClass("source-muted", false);
     if (config_["format-source-muted"].isString()) {
       format_source = config_["format-source"].asString();
     }
@@ -302,7 +302,7 @@ auto waybar::modules::Pulseaudio::update() -> void {
   if (text.empty()) {
     label_.hide();
   } else {
-    label_.set_markup(text);
+    setMarkup(text);
     label_.show();
   }
   getState(volume_);
@@ -312,13 +312,13 @@ auto waybar::modules::Pulseaudio::update() -> void {
       tooltip_format = config_["tooltip-format"].asString();
     }
     if (!tooltip_format.empty()) {
-      label_.set_tooltip_text(fmt::format(
+      setTooltipText(fmt::format(
           fmt::runtime(tooltip_format), fmt::arg("desc", desc_), fmt::arg("volume", volume_),
           fmt::arg("format_source", format_source), fmt::arg("source_volume", source_volume_),
           fmt::arg("source_desc", source_desc_),
           fmt::arg("icon", getIcon(volume_, getPulseIcon()))));
     } else {
-      label_.set_tooltip_text(desc_);
+      setTooltipText(desc_);
     }
   }
 
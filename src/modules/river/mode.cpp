@@ -98,12 +98,12 @@ void Mode::handle_mode(const char *mode) {
   if (format_.empty()) {
     label_.hide();
   } else {
-    if (!mode_.empty()) {
-      label_.get_style_context()->remove_class(mode_);
+    if (mode_ != mode) {
+      setClass(mode_, false);
     }
 
-    label_.get_style_context()->add_class(mode);
-    label_.set_markup(fmt::format(fmt::runtime(format_), Glib::Markup::escape_text(mode).raw()));
+    setClass(mode, true);
+    setMarkup(fmt::format(fmt::runtime(format_), Glib::Markup::escape_text(mode).raw()));
     label_.show();
   }
 
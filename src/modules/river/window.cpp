@@ -106,7 +106,7 @@ void Window::handle_focused_view(const char *title) {
     label_.hide();  // hide empty labels or labels with empty format
   } else {
     label_.show();
-    label_.set_markup(fmt::format(fmt::runtime(format_), Glib::Markup::escape_text(title).raw()));
+    setMarkup(fmt::format(fmt::runtime(format_), Glib::Markup::escape_text(title).raw()));
   }
 
   ALabel::update();
@@ -114,7 +114,7 @@ void Window::handle_focused_view(const char *title) {
 
 void Window::handle_focused_output(struct wl_output *output) {
   if (output_ == output) {  // if we focused the output this bar belongs to
-    label_.get_style_context()->add_class("focused");
+    setClass("focused", true);
     ALabel::update();
   }
   focused_output_ = output;
@@ -122,7 +122,7 @@ void Window::handle_focused_output(struct wl_output *output) {
 
 void Window::handle_unfocused_output(struct wl_output *output) {
   if (output_ == output) {  // if we unfocused the output this bar belongs to
-    label_.get_style_context()->remove_class("focused");
+    setClass("focused", false);
     ALabel::update();
   }
 }
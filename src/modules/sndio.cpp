@@ -104,18 +104,14 @@ auto Sndio::update() -> void {
   auto format = format_;
   unsigned int vol = 100. * static_cast<double>(volume_) / static_cast<double>(maxval_);
 
-  if (volume_ == 0) {
-    label_.get_style_context()->add_class("muted");
-  } else {
-    label_.get_style_context()->remove_class("muted");
-  }
+  setClass("muted", volume_ == 0);
 
   auto text =
       fmt::format(fmt::runtime(format), fmt::arg("volume", vol), fmt::arg("raw_value", volume_));
   if (text.empty()) {
     label_.hide();
   } else {
-    label_.set_markup(text);
+    setMarkup(text);
     label_.show();
   }
 
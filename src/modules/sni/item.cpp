@@ -9,6 +9,7 @@
 #include <map>
 
 #include "util/format.hpp"
+#include "util/icon_cache.hpp"
 
 template <>
 struct fmt::formatter<Glib::VariantBase> : formatter<std::string> {
@@ -297,50 +298,65 @@ Glib::RefPtr<Gdk::Pixbuf> Item::extractPixBuf(GVariant* variant) {
 }
 
 void Item::updateImage() {
-  auto pixbuf = getIconPixbuf();
-  auto scaled_icon_size = getScaledIconSize();
+  auto show = [this](const Cairo::RefPtr<Cairo::Surface>& surface) {
+    if (surface) {
+      image.set(surface);
+    }
+  };
+  if (icon_theme_path.empty() && !icon_name.empty() && icon_name.find('/') == std::string::npos &&
+      util::IconCache::inst().loadIcon(icon_request_, "", icon_name, icon_size,
+                                       image.get_scale_factor(), show)) {
+    // Named icon from the default theme, shared with the other items and bars
+    return;
+  }
+
+  // The current icon stays until the new one is decoded
+  icon_request_.start(getIconDecoder(), [this, show](Glib::RefPtr<Gdk::Pixbuf> pixbuf) {
+    if (pixbuf) {
+      show(Gdk::Cairo::create_surface_from_pixbuf(pixbuf, image.get_scale_factor(),
+                                                  image.get_window()));
+    }
+  });
+}
 
+std::function<Glib::RefPtr<Gdk::Pixbuf>()> Item::getIconDecoder() {
+  int scaled_icon_size = getScaledIconSize();
   // If the loaded icon is not square, assume that the icon height should match the
   // requested icon size, but the width is allowed to be different. As such, if the
   // height of the image does not match the requested icon size, resize the icon such that
   // the aspect ratio is maintained, but the height matches the requested icon size.
-  if (pixbuf->get_height() != scaled_icon_size) {
-    int width = scaled_icon_size * pixbuf->get_width() / pixbuf->get_height();
-    pixbuf = pixbuf->scale_simple(width, scaled_icon_size, Gdk::InterpType::INTERP_BILINEAR);
-  }
-
-  auto surface =
-      Gdk::Cairo::create_surface_from_pixbuf(pixbuf, image.get_scale_factor(), image.get_window());
-  image.set(surface);
-}
+  auto fit = [scaled_icon_size](Glib::RefPtr<Gdk::Pixbuf> pixbuf) {
+    if (pixbuf && pixbuf->get_height() != scaled_icon_size) {
+      int width = scaled_icon_size * pixbuf->get_width() / pixbuf->get_height();
+      pixbuf = pixbuf->scale_simple(width, scaled_icon_size, Gdk::InterpType::INTERP_BILINEAR);
+    }
+    return pixbuf;
+  };
 
-Glib::RefPtr<Gdk::Pixbuf> Item::getIconPixbuf() {
   if (!icon_name.empty()) {
-    try {
-      std::ifstream temp(icon_name);
-      if (temp.is_open()) {
-        return Gdk::Pixbuf::create_from_file(icon_name);
-      }
-    } catch (Glib::Error& e) {
-      // Ignore because we want to also try different methods of getting an icon.
-      //
-      // But a warning is logged, as the file apparently exists, but there was
-      // a failure in creating a pixbuf out of it.
-
-      spdlog::warn("Item '{}': {}", id, static_cast<std::string>(e.what()));
+    std::ifstream temp(icon_name);
+    if (temp.is_open()) {
+      return [fit, path = icon_name, pixmap = icon_pixmap, id = id, scaled_icon_size] {
+        try {
+          // Decoded right at the requested height, large SVGs are not rendered at full size
+          return fit(Gdk::Pixbuf::create_from_file(path, -1, scaled_icon_size));
+        } catch (const Glib::Error& e) {
+          // The file exists but can't be decoded, fall back to the pixmap
+          spdlog::warn("Item '{}': {}", id, static_cast<std::string>(e.what()));
+        }
+        return fit(pixmap);
+      };
     }
 
-    try {
-      // Will throw if it can not find an icon.
-      return getIconByName(icon_name, getScaledIconSize());
-    } catch (Glib::Error& e) {
-      spdlog::trace("Item '{}': {}", id, static_cast<std::string>(e.what()));
+    if (auto decoder = getIconByName(icon_name, scaled_icon_size)) {
+      return [fit, decoder] { return fit(decoder()); };
     }
+    spdlog::trace("Item '{}': no icon named '{}'", id, icon_name);
   }
 
   // Return the pixmap only if an icon for the given name could not be found.
   if (icon_pixmap) {
-    return icon_pixmap;
+    return [fit, pixmap = icon_pixmap] { return fit(pixmap); };
   }
 
   if (icon_name.empty()) {
@@ -350,10 +366,12 @@ Glib::RefPtr<Gdk::Pixbuf> Item::getIconPixbuf() {
                   icon_name);
   }
 
-  return getIconByName("image-missing", getScaledIconSize());
+  auto decoder = getIconByName("image-missing", scaled_icon_size);
+  return [fit, decoder] { return decoder ? fit(decoder()) : Glib::RefPtr<Gdk::Pixbuf>{}; };
 }
 
-Glib::RefPtr<Gdk::Pixbuf> Item::getIconByName(const std::string& name, int request_size) {
+std::function<Glib::RefPtr<Gdk::Pixbuf>()> Item::getIconByName(const std::string& name,
+                                                                int request_size) {
   int tmp_size = 0;
   icon_theme->rescan_if_needed();
   auto sizes = icon_theme->get_icon_sizes(name.c_str());
@@ -373,16 +391,34 @@ Glib::RefPtr<Gdk::Pixbuf> Item::getIconByName(const std::string& name, int reque
   if (tmp_size == 0) {
     tmp_size = request_size;
   }
-  if (!icon_theme_path.empty() &&
-      icon_theme->lookup_icon(name.c_str(), tmp_size,
-                              Gtk::IconLookupFlags::ICON_LOOKUP_FORCE_SIZE)) {
-    return icon_theme->load_icon(name.c_str(), tmp_size,
-                                 Gtk::IconLookupFlags::ICON_LOOKUP_FORCE_SIZE);
+  Gtk::IconInfo info;
+  if (!icon_theme_path.empty()) {
+    info = icon_theme->lookup_icon(name.c_str(), tmp_size,
+                                   Gtk::IconLookupFlags::ICON_LOOKUP_FORCE_SIZE);
+  }
+  if (!info) {
+    Glib::RefPtr<Gtk::IconTheme> default_theme = Gtk::IconTheme::get_default();
+    default_theme->rescan_if_needed();
+    info = default_theme->lookup_icon(name.c_str(), tmp_size,
+                                      Gtk::IconLookupFlags::ICON_LOOKUP_FORCE_SIZE);
+  }
+  if (!info) {
+    return {};
+  }
+
+  // Only the file is loaded on the worker, GTK can't be used there
+  std::string path = info.get_filename();
+  if (path.empty()) {
+    // Built into the resources of GTK, already in memory
+    try {
+      auto pixbuf = info.load_icon();
+      return [pixbuf] { return pixbuf; };
+    } catch (const Glib::Error& e) {
+      spdlog::trace("Item '{}': {}", id, static_cast<std::string>(e.what()));
+      return {};
+    }
   }
-  Glib::RefPtr<Gtk::IconTheme> default_theme = Gtk::IconTheme::get_default();
-  default_theme->rescan_if_needed();
-  return default_theme->load_icon(name.c_str(), tmp_size,
-                                  Gtk::IconLookupFlags::ICON_LOOKUP_FORCE_SIZE);
+  return [path, tmp_size] { return Gdk::Pixbuf::create_from_file(path, tmp_size, tmp_size); };
 }
 
 double Item::getScaledIconSize() {
@@ -47,17 +47,9 @@ BarIpcClient::BarIpcClient(waybar::Bar& bar) : bar_{bar} {
   // action.
   std::ostringstream oss_events;
   oss_events << subscribe_events;
-  ipc_.subscribe(oss_events.str());
   ipc_.signal_event.connect(sigc::mem_fun(*this, &BarIpcClient::onIpcEvent));
   ipc_.signal_cmd.connect(sigc::mem_fun(*this, &BarIpcClient::onCmd));
-  // Launch worker
-  ipc_.setWorker([this] {
-    try {
-      ipc_.handleEvent();
-    } catch (const std::exception& e) {
-      spdlog::error("BarIpcClient::handleEvent {}", e.what());
-    }
-  });
+  ipc_.subscribe(oss_events.str());
 }
 
 bool BarIpcClient::isModuleEnabled(std::string name) {
@@ -99,7 +91,7 @@ void BarIpcClient::onInitialConfig(const struct Ipc::ipc_response& res) {
 
 void BarIpcClient::onIpcEvent(const struct Ipc::ipc_response& res) {
   try {
-    auto payload = parser_.parse(res.payload);
+    const auto& payload = res.json();
     switch (res.type) {
       case IPC_EVENT_WORKSPACE:
         if (payload.isMember("change")) {
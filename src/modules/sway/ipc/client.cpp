@@ -1,36 +1,44 @@
 #include "modules/sway/ipc/client.hpp"
 
 #include <fcntl.h>
+#include <spdlog/spdlog.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
 
+#include <algorithm>
+#include <cstring>
+#include <deque>
+#include <future>
+#include <map>
+#include <mutex>
 #include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include "util/json.hpp"
 
 namespace waybar::modules::sway {
 
-Ipc::Ipc() {
-  const std::string& socketPath = getSocketPath();
-  fd_ = open(socketPath);
-  fd_event_ = open(socketPath);
-}
+namespace {
 
-Ipc::~Ipc() {
-  thread_.stop();
+const std::string IPC_MAGIC = "i3-ipc";
+const size_t IPC_HEADER_SIZE = IPC_MAGIC.size() + 8;
 
-  if (fd_ > 0) {
-    // To fail the IPC header
-    write(fd_, "close-sway-ipc", 14);
-    close(fd_);
-    fd_ = -1;
-  }
-  if (fd_event_ > 0) {
-    write(fd_event_, "close-sway-ipc", 14);
-    close(fd_event_);
-    fd_event_ = -1;
-  }
-}
-
-void Ipc::setWorker(std::function<void()>&& func) { thread_ = func; }
+const std::map<std::string, uint32_t, std::less<>> EVENT_TYPES = {
+    {"workspace", IPC_EVENT_WORKSPACE},
+    {"output", IPC_EVENT_OUTPUT},
+    {"mode", IPC_EVENT_MODE},
+    {"window", IPC_EVENT_WINDOW},
+    {"barconfig_update", IPC_EVENT_BARCONFIG_UPDATE},
+    {"binding", IPC_EVENT_BINDING},
+    {"shutdown", IPC_EVENT_SHUTDOWN},
+    {"tick", IPC_EVENT_TICK},
+    {"bar_state_update", IPC_EVENT_BAR_STATE_UPDATE},
+    {"input", IPC_EVENT_INPUT},
+};
 
-const std::string Ipc::getSocketPath() const {
+std::string getSocketPath() {
   const char* env = getenv("SWAYSOCK");
   if (env != nullptr) {
     return std::string(env);
@@ -58,7 +66,7 @@ const std::string Ipc::getSocketPath() const {
   return str;
 }
 
-int Ipc::open(const std::string& socketPath) const {
+int openSocket(const std::string& socketPath) {
   int32_t fd = socket(AF_UNIX, SOCK_STREAM, 0);
   if (fd == -1) {
     throw std::runtime_error("Unable to open Unix socket");
@@ -71,82 +79,281 @@ int Ipc::open(const std::string& socketPath) const {
   addr.sun_path[sizeof(addr.sun_path) - 1] = 0;
   int l = sizeof(struct sockaddr_un);
   if (::connect(fd, reinterpret_cast<struct sockaddr*>(&addr), l) == -1) {
+    close(fd);
     throw std::runtime_error("Unable to connect to Sway");
   }
   return fd;
 }
 
-struct Ipc::ipc_response Ipc::recv(int fd) {
-  std::string header;
-  header.resize(ipc_header_size_);
-  auto data32 = reinterpret_cast<uint32_t*>(header.data() + ipc_magic_.size());
+/* Send a message in a single write, so that it can't interleave with the ones of other threads */
+void writeMessage(int fd, uint32_t type, const std::string& payload) {
+  std::string message(IPC_HEADER_SIZE, '\0');
+  memcpy(message.data(), IPC_MAGIC.data(), IPC_MAGIC.size());
+  uint32_t header[2] = {static_cast<uint32_t>(payload.size()), type};
+  memcpy(message.data() + IPC_MAGIC.size(), header, sizeof(header));
+  message += payload;
+
   size_t total = 0;
+  while (total < message.size()) {
+    auto res = ::send(fd, message.data() + total, message.size() - total, MSG_NOSIGNAL);
+    if (res == -1) {
+      if (errno == EINTR) {
+        continue;
+      }
+      throw std::runtime_error("Unable to send IPC message");
+    }
+    total += res;
+  }
+}
+
+/**
+ * Splits the messages received on a socket.
+ *
+ * Receives as much as is available at once into a buffer reused for all the messages, so that a
+ * burst of events is read with a few recv() calls. Only the payload of a message is copied out of
+ * it, a payload larger than what was buffered is received directly into its string.
+ */
+class FrameReader {
+ public:
+  explicit FrameReader(int fd) : fd_(fd), buffer_(BUFFER_SIZE) {}
 
-  while (total < ipc_header_size_) {
-    auto res = ::recv(fd, header.data() + total, ipc_header_size_ - total, 0);
-    if (fd_event_ == -1 || fd_ == -1) {
-      // IPC is closed so just return an empty response
-      return {0, 0, ""};
+  Ipc::ipc_response next() {
+    fill(IPC_HEADER_SIZE);
+    const char* header = buffer_.data() + begin_;
+    if (memcmp(header, IPC_MAGIC.data(), IPC_MAGIC.size()) != 0) {
+      throw std::runtime_error("Invalid IPC magic");
     }
-    if (res <= 0) {
-      throw std::runtime_error("Unable to receive IPC header");
+    uint32_t data32[2];
+    memcpy(data32, header + IPC_MAGIC.size(), sizeof(data32));
+    begin_ += IPC_HEADER_SIZE;
+
+    const size_t size = data32[0];
+    std::string payload(size, '\0');
+    size_t total = std::min(size, end_ - begin_);
+    memcpy(payload.data(), buffer_.data() + begin_, total);
+    begin_ += total;
+    while (total < size) {
+      total += receive(payload.data() + total, size - total);
     }
-    total += res;
+    return {data32[0], data32[1], std::move(payload)};
   }
-  auto magic = std::string(header.data(), header.data() + ipc_magic_.size());
-  if (magic != ipc_magic_) {
-    throw std::runtime_error("Invalid IPC magic");
+
+ private:
+  static constexpr size_t BUFFER_SIZE = 64 * 1024;
+
+  /* Make sure that `size` bytes are buffered */
+  void fill(size_t size) {
+    if (begin_ == end_) {
+      begin_ = end_ = 0;
+    }
+    while (end_ - begin_ < size) {
+      if (buffer_.size() - begin_ < size) {
+        // Not enough room left for the end of the message
+        memmove(buffer_.data(), buffer_.data() + begin_, end_ - begin_);
+        end_ -= begin_;
+        begin_ = 0;
+      }
+      end_ += receive(buffer_.data() + end_, buffer_.size() - end_);
+    }
   }
 
-  total = 0;
-  std::string payload;
-  payload.resize(data32[0]);
-  while (total < data32[0]) {
-    auto res = ::recv(fd, payload.data() + total, data32[0] - total, 0);
-    if (res < 0) {
-      if (errno == EINTR || errno == EAGAIN) {
+  size_t receive(char* data, size_t size) {
+    while (true) {
+      auto res = ::recv(fd_, data, size, 0);
+      if (res > 0) {
+        return res;
+      }
+      if (res < 0 && errno == EINTR) {
         continue;
       }
-      throw std::runtime_error("Unable to receive IPC payload");
+      throw std::runtime_error(res == 0 ? "Connection closed by sway"
+                                        : "Unable to receive IPC message");
     }
-    total += res;
   }
-  return {data32[0], data32[1], &payload.front()};
-}
 
-struct Ipc::ipc_response Ipc::send(int fd, uint32_t type, const std::string& payload) {
-  std::string header;
-  header.resize(ipc_header_size_);
-  auto data32 = reinterpret_cast<uint32_t*>(header.data() + ipc_magic_.size());
-  memcpy(header.data(), ipc_magic_.c_str(), ipc_magic_.size());
-  data32[0] = payload.size();
-  data32[1] = type;
+  int fd_;
+  std::vector<char> buffer_;
+  // Received data not consumed yet
+  size_t begin_ = 0;
+  size_t end_ = 0;
+};
+
+}  // namespace
 
-  if (::send(fd, header.data(), ipc_header_size_, 0) == -1) {
-    throw std::runtime_error("Unable to send IPC header");
+/**
+ * The sockets shared by all the Ipc instances.
+ *
+ * sway answers the messages of a socket in order: each request queues a promise and whichever
+ * thread reads a reply fulfills the oldest one. Replies on the event socket (to subscriptions)
+ * are read by the event thread.
+ */
+class IpcHub {
+ public:
+  static IpcHub& inst() {
+    // Intentionally leaked like the Scheduler, the event thread is never joined
+    static auto hub = new IpcHub();
+    return *hub;
   }
-  if (::send(fd, payload.c_str(), payload.size(), 0) == -1) {
-    throw std::runtime_error("Unable to send IPC payload");
+
+  Ipc::ipc_response request(uint32_t type, const std::string& payload) {
+    std::future<Ipc::ipc_response> reply;
+    {
+      std::lock_guard<std::mutex> lock(cmd_write_mutex_);
+      writeMessage(cmd_fd_, type, payload);
+      reply = cmd_pending_.emplace_back().get_future();
+    }
+    while (reply.wait_for(std::chrono::seconds(0)) != std::future_status::ready) {
+      std::lock_guard<std::mutex> read_lock(cmd_read_mutex_);
+      if (reply.wait_for(std::chrono::seconds(0)) == std::future_status::ready) {
+        break;
+      }
+      try {
+        auto res = cmd_reader_.next();
+        std::lock_guard<std::mutex> lock(cmd_write_mutex_);
+        cmd_pending_.front().set_value(std::move(res));
+        cmd_pending_.pop_front();
+      } catch (const std::exception&) {
+        // The connection is broken, no reply will come anymore
+        fail(cmd_write_mutex_, cmd_pending_);
+      }
+    }
+    return reply.get();
   }
-  return Ipc::recv(fd);
+
+  void subscribe(Ipc* client, const std::string& payload) {
+    static const util::JsonParser parser;
+    uint32_t events = 0;
+    Json::Value missing(Json::arrayValue);
+    std::future<Ipc::ipc_response> reply;
+    {
+      std::lock_guard<std::mutex> lock(event_write_mutex_);
+      for (const auto& name : parser.parse(payload)) {
+        auto it = EVENT_TYPES.find(name.asString());
+        if (it == EVENT_TYPES.end()) {
+          throw std::runtime_error("Unable to subscribe ipc event " + name.asString());
+        }
+        events |= event_mask(it->second);
+        if ((subscribed_ & event_mask(it->second)) == 0) {
+          missing.append(name);
+        }
+      }
+      if (!missing.empty()) {
+        Json::StreamWriterBuilder writer;
+        writeMessage(event_fd_, IPC_SUBSCRIBE, Json::writeString(writer, missing));
+        reply = event_pending_.emplace_back().get_future();
+      }
+    }
+    if (reply.valid()) {
+      // The reply is read by the event thread
+      if (!reply.get().json()["success"].asBool()) {
+        throw std::runtime_error("Unable to subscribe ipc event");
+      }
+      std::lock_guard<std::mutex> lock(event_write_mutex_);
+      subscribed_ |= events;
+    }
+    std::lock_guard<std::mutex> lock(clients_mutex_);
+    if (client->events_ == 0) {
+      clients_.push_back(client);
+    }
+    client->events_ |= events;
+  }
+
+  void remove(Ipc* client) {
+    // Waits for the handlers of the client running on the event thread
+    std::lock_guard<std::mutex> lock(clients_mutex_);
+    clients_.erase(std::remove(clients_.begin(), clients_.end(), client), clients_.end());
+  }
+
+ private:
+  IpcHub() : IpcHub(getSocketPath()) {}
+
+  explicit IpcHub(const std::string& socket_path)
+      : cmd_fd_(openSocket(socket_path)),
+        cmd_reader_(cmd_fd_),
+        event_fd_(openSocket(socket_path)),
+        event_reader_(event_fd_) {
+    thread_ = std::thread([this] { readEvents(); });
+  }
+
+  static void fail(std::mutex& mutex, std::deque<std::promise<Ipc::ipc_response>>& pending) {
+    std::lock_guard<std::mutex> lock(mutex);
+    for (auto& promise : pending) {
+      promise.set_exception(std::current_exception());
+    }
+    pending.clear();
+  }
+
+  void readEvents() {
+    while (true) {
+      Ipc::ipc_response res;
+      try {
+        res = event_reader_.next();
+      } catch (const std::exception& e) {
+        spdlog::error("Sway IPC: {}, no more events will be received", e.what());
+        fail(event_write_mutex_, event_pending_);
+        return;
+      }
+      if ((res.type & IPC_EVENT_WORKSPACE) == 0) {
+        // Not an event, the reply of a subscription
+        std::lock_guard<std::mutex> lock(event_write_mutex_);
+        if (!event_pending_.empty()) {
+          event_pending_.front().set_value(std::move(res));
+          event_pending_.pop_front();
+        }
+        continue;
+      }
+      std::lock_guard<std::mutex> lock(clients_mutex_);
+      for (auto* client : clients_) {
+        if ((client->events_ & event_mask(res.type)) == 0) {
+          continue;
+        }
+        try {
+          client->signal_event.emit(res);
+        } catch (const std::exception& e) {
+          spdlog::error("Sway IPC event handler: {}", e.what());
+        }
+      }
+    }
+  }
+
+  int cmd_fd_;
+  FrameReader cmd_reader_;
+  std::mutex cmd_write_mutex_;
+  std::mutex cmd_read_mutex_;
+  std::deque<std::promise<Ipc::ipc_response>> cmd_pending_;
+
+  int event_fd_;
+  FrameReader event_reader_;
+  std::mutex event_write_mutex_;
+  std::deque<std::promise<Ipc::ipc_response>> event_pending_;
+  uint32_t subscribed_ = 0;
+
+  std::mutex clients_mutex_;
+  std::vector<Ipc*> clients_;
+  std::thread thread_;
+};
+
+const Json::Value& Ipc::ipc_response::json() const {
+  if (!parsed) {
+    static const util::JsonParser parser;
+    parsed = parser.parse(payload);
+  }
+  return *parsed;
 }
 
+Ipc::Ipc() {
+  // Connects on the first use, throws if sway can't be reached
+  IpcHub::inst();
+}
+
+Ipc::~Ipc() { IpcHub::inst().remove(this); }
+
 void Ipc::sendCmd(uint32_t type, const std::string& payload) {
   std::lock_guard<std::mutex> lock(mutex_);
-  const auto res = Ipc::send(fd_, type, payload);
+  const auto res = IpcHub::inst().request(type, payload);
   signal_cmd.emit(res);
 }
 
-void Ipc::subscribe(const std::string& payload) {
-  auto res = Ipc::send(fd_event_, IPC_SUBSCRIBE, payload);
-  if (res.payload != "{\"success\": true}") {
-    throw std::runtime_error("Unable to subscribe ipc event");
-  }
-}
-
-void Ipc::handleEvent() {
-  const auto res = Ipc::recv(fd_event_);
-  signal_event.emit(res);
-}
+void Ipc::subscribe(const std::string& payload) { IpcHub::inst().subscribe(this, payload); }
 
 }  // namespace waybar::modules::sway
@@ -29,18 +29,10 @@ Language::Language(const std::string& id, const Json::Value& config)
   if (config.isMember("tooltip-format")) {
     tooltip_format_ = config["tooltip-format"].asString();
   }
-  ipc_.subscribe(R"(["input"])");
   ipc_.signal_event.connect(sigc::mem_fun(*this, &Language::onEvent));
   ipc_.signal_cmd.connect(sigc::mem_fun(*this, &Language::onCmd));
+  ipc_.subscribe(R"(["input"])");
   ipc_.sendCmd(IPC_GET_INPUTS);
-  // Launch worker
-  ipc_.setWorker([this] {
-    try {
-      ipc_.handleEvent();
-    } catch (const std::exception& e) {
-      spdlog::error("Language: {}", e.what());
-    }
-  });
   dp.emit();
 }
 
@@ -83,7 +75,7 @@ void Language::onEvent(const struct Ipc::ipc_response& res) {
 
   try {
     std::lock_guard<std::mutex> lock(mutex_);
-    auto payload = parser_.parse(res.payload)["input"];
+    const auto& payload = res.json()["input"];
     if (payload["type"].asString() == "keyboard") {
       set_current_layout(payload[XKB_ACTIVE_LAYOUT_NAME_KEY].asString());
     }
@@ -99,7 +91,12 @@ auto Language::update() -> void {
       fmt::runtime(format_), fmt::arg("short", layout_.short_name),
       fmt::arg("shortDescription", layout_.short_description), fmt::arg("long", layout_.full_name),
       fmt::arg("variant", layout_.variant), fmt::arg("flag", layout_.country_flag())));
-  label_.set_markup(display_layout);
+  setMarkup(display_layout);
+  if (layout_class_ != layout_.short_name) {
+    setClass(layout_class_, false);
+    layout_class_ = layout_.short_name;
+    setClass(layout_class_, true);
+  }
   if (tooltipEnabled()) {
     if (tooltip_format_ != "") {
       auto tooltip_display_layout = trim(
@@ -107,9 +104,9 @@ auto Language::update() -> void {
                       fmt::arg("shortDescription", layout_.short_description),
                       fmt::arg("long", layout_.full_name), fmt::arg("variant", layout_.variant),
                       fmt::arg("flag", layout_.country_flag())));
-      label_.set_tooltip_markup(tooltip_display_layout);
+      setTooltipMarkup(tooltip_display_layout);
     } else {
-      label_.set_tooltip_markup(display_layout);
+      setTooltipMarkup(display_layout);
     }
   }
 
@@ -120,9 +117,7 @@ auto Language::update() -> void {
 }
 
 auto Language::set_current_layout(std::string current_layout) -> void {
-  label_.get_style_context()->remove_class(layout_.short_name);
   layout_ = layouts_map_[current_layout];
-  label_.get_style_context()->add_class(layout_.short_name);
 }
 
 auto Language::init_layouts_map(const std::vector<std::string>& used_layouts) -> void {
@@ -14,38 +14,25 @@ Scratchpad::Scratchpad(const std::string& id, const Json::Value& config)
       tooltip_enabled_(config_["tooltip"].isBool() ? config_["tooltip"].asBool() : true),
       tooltip_text_(""),
       count_(0) {
-  ipc_.subscribe(R"(["window"])");
   ipc_.signal_event.connect(sigc::mem_fun(*this, &Scratchpad::onEvent));
   ipc_.signal_cmd.connect(sigc::mem_fun(*this, &Scratchpad::onCmd));
+  ipc_.subscribe(R"(["window"])");
 
   getTree();
-
-  ipc_.setWorker([this] {
-    try {
-      ipc_.handleEvent();
-    } catch (const std::exception& e) {
-      spdlog::error("Scratchpad: {}", e.what());
-    }
-  });
 }
 auto Scratchpad::update() -> void {
   if (count_ || show_empty_) {
     event_box_.show();
-    label_.set_markup(
-        fmt::format(fmt::runtime(format_),
-                    fmt::arg("icon", getIcon(count_, "", config_["format-icons"].size())),
-                    fmt::arg("count", count_)));
+    setMarkup(fmt::format(fmt::runtime(format_),
+                          fmt::arg("icon", getIcon(count_, "", config_["format-icons"].size())),
+                          fmt::arg("count", count_)));
     if (tooltip_enabled_) {
-      label_.set_tooltip_markup(tooltip_text_);
+      setTooltipMarkup(tooltip_text_);
     }
   } else {
     event_box_.hide();
   }
-  if (count_) {
-    label_.get_style_context()->remove_class("empty");
-  } else {
-    label_.get_style_context()->add_class("empty");
-  }
+  setClass("empty", count_ == 0);
   ALabel::update();
 }
 
@@ -8,44 +8,88 @@
 #include <gtkmm/icontheme.h>
 #include <spdlog/spdlog.h>
 
+#include <chrono>
 #include <filesystem>
 #include <regex>
 #include <string>
 
+#include "util/desktop_index.hpp"
+#include "util/icon_cache.hpp"
 #include "util/rewrite_title.hpp"
 
 namespace waybar::modules::sway {
 
 Window::Window(const std::string& id, const Bar& bar, const Json::Value& config)
-    : AIconLabel(config, "window", id, "{}", 0, true), bar_(bar), windowId_(-1) {
+    : AIconLabel(config, "window", id, "{}", 0, true),
+      bar_(bar),
+      windowId_(-1),
+      rewrite_rules_(config["rewrite"]) {
   // Icon size
   if (config_["icon-size"].isUInt()) {
     app_icon_size_ = config["icon-size"].asUInt();
   }
   image_.set_pixel_size(app_icon_size_);
 
-  ipc_.subscribe(R"(["window","workspace"])");
   ipc_.signal_event.connect(sigc::mem_fun(*this, &Window::onEvent));
   ipc_.signal_cmd.connect(sigc::mem_fun(*this, &Window::onCmd));
+  ipc_.subscribe(R"(["window","workspace"])");
   // Get Initial focused window
   getTree();
-  // Launch worker
-  ipc_.setWorker([this] {
-    try {
-      ipc_.handleEvent();
-    } catch (const std::exception& e) {
-      spdlog::error("Window: {}", e.what());
-      spdlog::trace("Window::Window exception");
+}
+
+Window::~Window() { title_timer_.disconnect(); }
+
+void Window::onEvent(const struct Ipc::ipc_response& res) {
+  if (res.type == IPC_EVENT_WINDOW) {
+    const auto& event = res.json();
+    const auto change = event["change"].asString();
+    const auto& container = event["container"];
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (change == "mark" || change == "urgent") {
+      // Nothing shown depends on them
+      return;
     }
-  });
+    if (change == "title") {
+      if (container["id"].asInt() == windowId_) {
+        setTitle(container["name"].asString());
+      }
+      return;
+    }
+    if (change == "focus" && workspace_windows_.count(container["id"].asInt()) > 0) {
+      // Another window of the same workspace: the counts and the layout are still valid
+      setFocusedWindow(container);
+      updateAppIconName();
+      dp.emit();
+      return;
+    }
+  }
+  getTree();
 }
 
-void Window::onEvent(const struct Ipc::ipc_response& res) { getTree(); }
+// Only the title changed, update() throttles the redraws
+void Window::setTitle(const std::string& title) {
+  window_ = Glib::Markup::escape_text(title);
+  title_only_ = true;
+  dp.emit();
+}
+
+void Window::setFocusedWindow(const Json::Value& container) {
+  title_only_ = false;
+  windowId_ = container["id"].asInt();
+  window_ = Glib::Markup::escape_text(container["name"].asString());
+  app_id_ = container["app_id"].isString() ? container["app_id"].asString()
+                                           : container["window_properties"]["instance"].asString();
+  app_class_ = container["window_properties"]["class"].isString()
+                   ? container["window_properties"]["class"].asString()
+                   : "";
+  shell_ = container["shell"].isString() ? container["shell"].asString() : "";
+}
 
 void Window::onCmd(const struct Ipc::ipc_response& res) {
   try {
     std::lock_guard<std::mutex> lock(mutex_);
     auto payload = parser_.parse(res.payload);
+    title_only_ = false;
     auto output = payload["output"].isString() ? payload["output"].asString() : "";
     std::tie(app_nb_, floating_count_, windowId_, window_, app_id_, app_class_, shell_, layout_) =
         getFocusedNode(payload["nodes"], output);
@@ -77,6 +121,13 @@ std::optional<std::string> getDesktopFilePath(const std::string& app_id,
 }
 
 std::optional<Glib::ustring> getIconName(const std::string& app_id, const std::string& app_class) {
+  for (const auto& name : {app_id, app_class}) {
+    auto entry = name.empty() ? std::nullopt : util::DesktopIndex::inst().find(name);
+    if (entry && !entry->icon.empty()) {
+      return entry->icon;
+    }
+  }
+
   const auto desktop_file_path = getDesktopFilePath(app_id, app_class);
   if (!desktop_file_path.has_value()) {
     // Try some heuristics to find a matching icon
@@ -136,12 +187,10 @@ void Window::updateAppIconName() {
     return;
   }
 
-  const auto icon_name = getIconName(app_id_, app_class_);
-  if (icon_name.has_value()) {
-    app_icon_name_ = icon_name.value();
-  } else {
-    app_icon_name_ = "";
-  }
+  // Focus changes between the same applications all the time, don't probe the data dirs again
+  app_icon_name_ = util::IconCache::inst().iconName(app_id_ + '\n' + app_class_, [this] {
+    return getIconName(app_id_, app_class_).value_or("");
+  });
   update_app_icon_ = true;
 }
 
@@ -158,6 +207,27 @@ void Window::updateAppIcon() {
 }
 
 auto Window::update() -> void {
+  {
+    // Titles may change several times per second (e.g. video players, terminals), redraw them at
+    // most every TITLE_UPDATE_INTERVAL and show the last one once the changes stop
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto now = std::chrono::steady_clock::now();
+    if (title_only_ && now < last_title_update_ + TITLE_UPDATE_INTERVAL) {
+      if (!title_timer_.connected()) {
+        auto delay = std::chrono::duration_cast<std::chrono::milliseconds>(
+            last_title_update_ + TITLE_UPDATE_INTERVAL - now);
+        title_timer_ = Glib::signal_timeout().connect(
+            [this] {
+              dp.emit();
+              return false;
+            },
+            delay.count() + 1);
+      }
+      return;
+    }
+    title_only_ = false;
+    last_title_update_ = now;
+  }
   spdlog::trace("workspace layout {}, tiled count {}, floating count {}", layout_, app_nb_,
                 floating_count_);
 
@@ -204,12 +274,10 @@ auto Window::update() -> void {
     old_app_id_ = app_id_;
   }
 
-  label_.set_markup(
-      fmt::format(fmt::runtime(format_),
-                  fmt::arg("title", waybar::util::rewriteTitle(window_, config_["rewrite"])),
-                  fmt::arg("app_id", app_id_), fmt::arg("shell", shell_)));
+  setMarkup(fmt::format(fmt::runtime(format_), fmt::arg("title", rewrite_rules_.apply(window_)),
+                        fmt::arg("app_id", app_id_), fmt::arg("shell", shell_)));
   if (tooltipEnabled()) {
-    label_.set_tooltip_text(window_);
+    setTooltipText(window_);
   }
 
   updateAppIcon();
@@ -255,6 +323,23 @@ std::pair<int, int> leafNodesInWorkspace(const Json::Value& node) {
   return {sum, floating_sum};
 }
 
+void windowsInWorkspace(const Json::Value& node, std::unordered_set<int>& ids) {
+  auto const& nodes = node["nodes"];
+  auto const& floating_nodes = node["floating_nodes"];
+  if (nodes.empty() && floating_nodes.empty()) {
+    if (node["type"].asString() != "workspace") {
+      ids.insert(node["id"].asInt());
+    }
+    return;
+  }
+  for (auto const& node : nodes) {
+    windowsInWorkspace(node, ids);
+  }
+  for (auto const& node : floating_nodes) {
+    windowsInWorkspace(node, ids);
+  }
+}
+
 std::tuple<std::size_t, int, int, std::string, std::string, std::string, std::string, std::string>
 gfnWithWorkspace(const Json::Value& nodes, std::string& output, const Json::Value& config_,
                  const Bar& bar_, Json::Value& parentWorkspace,
@@ -354,7 +439,13 @@ gfnWithWorkspace(const Json::Value& nodes, std::string& output, const Json::Valu
 std::tuple<std::size_t, int, int, std::string, std::string, std::string, std::string, std::string>
 Window::getFocusedNode(const Json::Value& nodes, std::string& output) {
   Json::Value placeholder = Json::Value::null;
-  return gfnWithWorkspace(nodes, output, config_, bar_, placeholder, placeholder);
+  auto focused = gfnWithWorkspace(nodes, output, config_, bar_, placeholder, placeholder);
+  // When a window is focused, placeholder is its workspace
+  workspace_windows_.clear();
+  if (!std::get<6>(focused).empty() && placeholder["type"].asString() == "workspace") {
+    windowsInWorkspace(placeholder, workspace_windows_);
+  }
+  return focused;
 }
 
 void Window::getTree() {
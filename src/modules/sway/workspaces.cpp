@@ -33,28 +33,32 @@ Workspaces::Workspaces(const std::string &id, const Bar &bar, const Json::Value
     box_.get_style_context()->add_class(id);
   }
   event_box_.add(box_);
-  ipc_.subscribe(R"(["workspace"])");
   ipc_.signal_event.connect(sigc::mem_fun(*this, &Workspaces::onEvent));
   ipc_.signal_cmd.connect(sigc::mem_fun(*this, &Workspaces::onCmd));
+  ipc_.subscribe(R"(["workspace"])");
   ipc_.sendCmd(IPC_GET_WORKSPACES);
   if (config["enable-bar-scroll"].asBool()) {
     auto &window = const_cast<Bar &>(bar_).window;
     window.add_events(Gdk::SCROLL_MASK | Gdk::SMOOTH_SCROLL_MASK);
     window.signal_scroll_event().connect(sigc::mem_fun(*this, &Workspaces::handleScroll));
   }
-  // Launch worker
-  ipc_.setWorker([this] {
-    try {
-      ipc_.handleEvent();
-    } catch (const std::exception &e) {
-      spdlog::error("Workspaces: {}", e.what());
-    }
-  });
 }
 
 void Workspaces::onEvent(const struct Ipc::ipc_response &res) {
   try {
-    ipc_.sendCmd(IPC_GET_WORKSPACES);
+    bool applied;
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      applied = applyEvent(res.json());
+      if (applied) {
+        updateWorkspaces();
+      }
+    }
+    if (applied) {
+      dp.emit();
+    } else {
+      ipc_.sendCmd(IPC_GET_WORKSPACES);
+    }
   } catch (const std::exception &e) {
     spdlog::error("Workspaces: {}", e.what());
   }
@@ -66,111 +70,171 @@ void Workspaces::onCmd(const struct Ipc::ipc_response &res) {
       {
         std::lock_guard<std::mutex> lock(mutex_);
         auto payload = parser_.parse(res.payload);
-        workspaces_.clear();
-        std::copy_if(payload.begin(), payload.end(), std::back_inserter(workspaces_),
-                     [&](const auto &workspace) {
-                       return !config_["all-outputs"].asBool()
-                                  ? workspace["output"].asString() == bar_.output->name
-                                  : true;
-                     });
+        sway_workspaces_.assign(payload.begin(), payload.end());
+        updateWorkspaces();
+      }
+      dp.emit();
+    } catch (const std::exception &e) {
+      spdlog::error("Workspaces: {}", e.what());
+    }
+  }
+}
+
+// Apply the change of a workspace event to sway_workspaces_, without asking sway for all the
+// workspaces again. Returns false when the event doesn't tell enough to do so.
+bool Workspaces::applyEvent(const Json::Value &event) {
+  const auto change = event["change"].asString();
+  const auto &current = event["current"];
+  auto it = std::find_if(
+      sway_workspaces_.begin(), sway_workspaces_.end(),
+      [&current](const auto &workspace) { return workspace["id"] == current["id"]; });
+
+  if (change == "init") {
+    if (it != sway_workspaces_.end()) {
+      return true;  // already listed by GET_WORKSPACES
+    }
+    // The node comes with its containers, which are not part of GET_WORKSPACES
+    Json::Value workspace = current;
+    workspace.removeMember("nodes");
+    workspace.removeMember("floating_nodes");
+    // Only the focused workspace of the seat is marked as focused, see the "focus" event
+    workspace["focused"] = false;
+    // Keep the workspaces of an output together, as sway lists them
+    auto last = std::find_if(sway_workspaces_.rbegin(), sway_workspaces_.rend(),
+                             [&current](const auto &workspace) {
+                               return workspace["output"] == current["output"];
+                             });
+    sway_workspaces_.insert(last == sway_workspaces_.rend() ? sway_workspaces_.end() : last.base(),
+                            std::move(workspace));
+    return true;
+  }
+  if (it == sway_workspaces_.end()) {
+    // Not known yet, e.g. the event came before the reply to GET_WORKSPACES
+    return false;
+  }
+  if (change == "empty") {
+    sway_workspaces_.erase(it);
+  } else if (change == "focus") {
+    for (auto &workspace : sway_workspaces_) {
+      workspace["focused"] = false;
+      if (workspace["output"] == current["output"]) {
+        workspace["visible"] = false;
+      }
+    }
+    (*it)["focused"] = true;
+    (*it)["visible"] = true;
+  } else if (change == "rename") {
+    (*it)["name"] = current["name"];
+    (*it)["num"] = current["num"];
+  } else if (change == "urgent") {
+    (*it)["urgent"] = current["urgent"];
+  } else {
+    // "move", "reload"...: the other workspaces of the outputs may have changed as well
+    return false;
+  }
+  return true;
+}
 
-        // adding persistent workspaces (as per the config file)
-        if (config_["persistent_workspaces"].isObject()) {
-          const Json::Value &p_workspaces = config_["persistent_workspaces"];
-          const std::vector<std::string> p_workspaces_names = p_workspaces.getMemberNames();
+void Workspaces::updateWorkspaces() {
+  workspaces_.clear();
+  std::copy_if(sway_workspaces_.begin(), sway_workspaces_.end(), std::back_inserter(workspaces_),
+               [&](const auto &workspace) {
+                 return !config_["all-outputs"].asBool()
+                            ? workspace["output"].asString() == bar_.output->name
+                            : true;
+               });
 
-          for (const std::string &p_w_name : p_workspaces_names) {
-            const Json::Value &p_w = p_workspaces[p_w_name];
-            auto it =
-                std::find_if(payload.begin(), payload.end(), [&p_w_name](const Json::Value &node) {
-                  return node["name"].asString() == p_w_name;
-                });
+  // adding persistent workspaces (as per the config file)
+  if (config_["persistent_workspaces"].isObject()) {
+    const Json::Value &p_workspaces = config_["persistent_workspaces"];
+    const std::vector<std::string> p_workspaces_names = p_workspaces.getMemberNames();
 
-            if (it != payload.end()) {
-              continue;  // already displayed by some bar
-            }
+    for (const std::string &p_w_name : p_workspaces_names) {
+      const Json::Value &p_w = p_workspaces[p_w_name];
+      auto it = std::find_if(sway_workspaces_.begin(), sway_workspaces_.end(),
+                             [&p_w_name](const Json::Value &node) {
+                               return node["name"].asString() == p_w_name;
+                             });
 
-            if (p_w.isArray() && !p_w.empty()) {
-              // Adding to target outputs
-              for (const Json::Value &output : p_w) {
-                if (output.asString() == bar_.output->name) {
-                  Json::Value v;
-                  v["name"] = p_w_name;
-                  v["target_output"] = bar_.output->name;
-                  v["num"] = convertWorkspaceNameToNum(p_w_name);
-                  workspaces_.emplace_back(std::move(v));
-                  break;
-                }
-              }
-            } else {
-              // Adding to all outputs
-              Json::Value v;
-              v["name"] = p_w_name;
-              v["target_output"] = "";
-              v["num"] = convertWorkspaceNameToNum(p_w_name);
-              workspaces_.emplace_back(std::move(v));
-            }
-          }
-        }
+      if (it != sway_workspaces_.end()) {
+        continue;  // already displayed by some bar
+      }
 
-        // sway has a defined ordering of workspaces that should be preserved in
-        // the representation displayed by waybar to ensure that commands such
-        // as "workspace prev" or "workspace next" make sense when looking at
-        // the workspace representation in the bar.
-        // Due to waybar's own feature of persistent workspaces unknown to sway,
-        // custom sorting logic is necessary to make these workspaces appear
-        // naturally in the list of workspaces without messing up sway's
-        // sorting. For this purpose, a custom numbering property is created
-        // that preserves the order provided by sway while inserting numbered
-        // persistent workspaces at their natural positions.
-        //
-        // All of this code assumes that sway provides numbered workspaces first
-        // and other workspaces are sorted by their creation time.
-        //
-        // In a first pass, the maximum "num" value is computed to enqueue
-        // unnumbered workspaces behind numbered ones when computing the sort
-        // attribute.
-        //
-        // Note: if the 'alphabetical_sort' option is true, the user is in
-        // agreement that the "workspace prev/next" commands may not follow
-        // the order displayed in Waybar.
-        int max_num = -1;
-        for (auto &workspace : workspaces_) {
-          max_num = std::max(workspace["num"].asInt(), max_num);
-        }
-        for (auto &workspace : workspaces_) {
-          auto workspace_num = workspace["num"].asInt();
-          if (workspace_num > -1) {
-            workspace["sort"] = workspace_num;
-          } else {
-            workspace["sort"] = ++max_num;
+      if (p_w.isArray() && !p_w.empty()) {
+        // Adding to target outputs
+        for (const Json::Value &output : p_w) {
+          if (output.asString() == bar_.output->name) {
+            Json::Value v;
+            v["name"] = p_w_name;
+            v["target_output"] = bar_.output->name;
+            v["num"] = convertWorkspaceNameToNum(p_w_name);
+            workspaces_.emplace_back(std::move(v));
+            break;
           }
         }
-        std::sort(workspaces_.begin(), workspaces_.end(),
-                  [this](const Json::Value &lhs, const Json::Value &rhs) {
-                    auto lname = lhs["name"].asString();
-                    auto rname = rhs["name"].asString();
-                    int l = lhs["sort"].asInt();
-                    int r = rhs["sort"].asInt();
-
-                    if (l == r || config_["alphabetical_sort"].asBool()) {
-                      // In case both integers are the same, lexicographical
-                      // sort. The code above already ensure that this will only
-                      // happened in case of explicitly numbered workspaces.
-                      //
-                      // Additionally, if the config specifies to sort workspaces
-                      // alphabetically do this here.
-                      return lname < rname;
-                    }
-
-                    return l < r;
-                  });
+      } else {
+        // Adding to all outputs
+        Json::Value v;
+        v["name"] = p_w_name;
+        v["target_output"] = "";
+        v["num"] = convertWorkspaceNameToNum(p_w_name);
+        workspaces_.emplace_back(std::move(v));
       }
-      dp.emit();
-    } catch (const std::exception &e) {
-      spdlog::error("Workspaces: {}", e.what());
     }
   }
+
+  // sway has a defined ordering of workspaces that should be preserved in
+  // the representation displayed by waybar to ensure that commands such
+  // as "workspace prev" or "workspace next" make sense when looking at
+  // the workspace representation in the bar.
+  // Due to waybar's own feature of persistent workspaces unknown to sway,
+  // custom sorting logic is necessary to make these workspaces appear
+  // naturally in the list of workspaces without messing up sway's
+  // sorting. For this purpose, a custom numbering property is created
+  // that preserves the order provided by sway while inserting numbered
+  // persistent workspaces at their natural positions.
+  //
+  // All of this code assumes that sway provides numbered workspaces first
+  // and other workspaces are sorted by their creation time.
+  //
+  // In a first pass, the maximum "num" value is computed to enqueue
+  // unnumbered workspaces behind numbered ones when computing the sort
+  // attribute.
+  //
+  // Note: if the 'alphabetical_sort' option is true, the user is in
+  // agreement that the "workspace prev/next" commands may not follow
+  // the order displayed in Waybar.
+  int max_num = -1;
+  for (auto &workspace : workspaces_) {
+    max_num = std::max(workspace["num"].asInt(), max_num);
+  }
+  for (auto &workspace : workspaces_) {
+    auto workspace_num = workspace["num"].asInt();
+    if (workspace_num > -1) {
+      workspace["sort"] = workspace_num;
+    } else {
+      workspace["sort"] = ++max_num;
+    }
+  }
+  std::sort(workspaces_.begin(), workspaces_.end(),
+            [this](const Json::Value &lhs, const Json::Value &rhs) {
+              auto lname = lhs["name"].asString();
+              auto rname = rhs["name"].asString();
+              int l = lhs["sort"].asInt();
+              int r = rhs["sort"].asInt();
+
+              if (l == r || config_["alphabetical_sort"].asBool()) {
+                // In case both integers are the same, lexicographical
+                // sort. The code above already ensure that this will only
+                // happened in case of explicitly numbered workspaces.
+                //
+                // Additionally, if the config specifies to sort workspaces
+                // alphabetically do this here.
+                return lname < rname;
+              }
+
+              return l < r;
+            });
 }
 
 bool Workspaces::filterButtons() {
@@ -180,6 +244,7 @@ bool Workspaces::filterButtons() {
                            [it](const auto &node) { return node["name"].asString() == it->first; });
     if (ws == workspaces_.end() ||
         (!config_["all-outputs"].asBool() && (*ws)["output"].asString() != bar_.output->name)) {
+      button_nodes_.erase(it->first);
       it = buttons_.erase(it);
       needReorder = true;
     } else {
@@ -198,6 +263,14 @@ auto Workspaces::update() -> void {
       needReorder = true;
     }
     auto &button = bit == buttons_.end() ? addButton(*it) : bit->second;
+    if (needReorder) {
+      box_.reorder_child(button, it - workspaces_.begin());
+    }
+    auto &shown = button_nodes_[(*it)["name"].asString()];
+    if (shown == *it) {
+      continue;  // unchanged by the last events
+    }
+    shown = *it;
     if ((*it)["focused"].asBool()) {
       button.get_style_context()->add_class("focused");
     } else {
@@ -227,9 +300,6 @@ auto Workspaces::update() -> void {
     } else {
       button.get_style_context()->remove_class("current_output");
     }
-    if (needReorder) {
-      box_.reorder_child(button, it - workspaces_.begin());
-    }
     std::string output = (*it)["name"].asString();
     if (config_["format"].isString()) {
       auto format = config_["format"].asString();
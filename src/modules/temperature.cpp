@@ -27,10 +27,7 @@ waybar::modules::Temperature::Temperature(const std::string& id, const Json::Val
     throw std::runtime_error("Can't open " + file_path_);
   }
 #endif
-  thread_ = [this] {
-    dp.emit();
-    thread_.sleep_for(interval_);
-  };
+  timer_.start(interval_, [this] { dp.emit(); });
 }
 
 auto waybar::modules::Temperature::update() -> void {
@@ -42,9 +39,9 @@ auto waybar::modules::Temperature::update() -> void {
   auto format = format_;
   if (critical) {
     format = config_["format-critical"].isString() ? config_["format-critical"].asString() : format;
-    label_.get_style_context()->add_class("critical");
+    setClass("critical", true);
   } else {
-    label_.get_style_context()->remove_class("critical");
+    setClass("critical", false);
   }
 
   if (format.empty()) {
@@ -55,18 +52,21 @@ auto waybar::modules::Temperature::update() -> void {
   }
 
   auto max_temp = config_["critical-threshold"].isInt() ? config_["critical-threshold"].asInt() : 0;
-  label_.set_markup(fmt::format(fmt::runtime(format), fmt::arg("temperatureC", temperature_c),
-                                fmt::arg("temperatureF", temperature_f),
-                                fmt::arg("temperatureK", temperature_k),
-                                fmt::arg("icon", getIcon(temperature_c, "", max_temp))));
+  const auto& format_template = formats_.get(format);
+  auto icon = format_template.uses("icon") ? getIcon(temperature_c, "", max_temp) : "";
+  setMarkup(format_template.render(
+      fmt::arg("temperatureC", temperature_c), fmt::arg("temperatureF", temperature_f),
+      fmt::arg("temperatureK", temperature_k), fmt::arg("icon", icon)));
   if (tooltipEnabled()) {
-    std::string tooltip_format = "{temperatureC}°C";
-    if (config_["tooltip-format"].isString()) {
-      tooltip_format = config_["tooltip-format"].asString();
-    }
-    label_.set_tooltip_text(fmt::format(
-        fmt::runtime(tooltip_format), fmt::arg("temperatureC", temperature_c),
-        fmt::arg("temperatureF", temperature_f), fmt::arg("temperatureK", temperature_k)));
+    setTooltipRenderer([this, temperature_c, temperature_f, temperature_k] {
+      std::string tooltip_format = "{temperatureC}°C";
+      if (config_["tooltip-format"].isString()) {
+        tooltip_format = config_["tooltip-format"].asString();
+      }
+      return formats_.get(tooltip_format)
+          .render(fmt::arg("temperatureC", temperature_c), fmt::arg("temperatureF", temperature_f),
+                  fmt::arg("temperatureK", temperature_k));
+    });
   }
   // Call parent update
   ALabel::update();
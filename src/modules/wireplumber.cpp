@@ -275,14 +275,14 @@ auto waybar::modules::Wireplumber::update() -> void {
 
   if (muted_) {
     format = config_["format-muted"].isString() ? config_["format-muted"].asString() : format;
-    label_.get_style_context()->add_class("muted");
+    setClass("muted", true);
   } else {
-    label_.get_style_context()->remove_class("muted");
+    setClass("muted", false);
   }
 
   std::string markup = fmt::format(fmt::runtime(format), fmt::arg("node_name", node_name_),
                                    fmt::arg("volume", volume_), fmt::arg("icon", getIcon(volume_)));
-  label_.set_markup(markup);
+  setMarkup(markup);
 
   getState(volume_);
 
@@ -292,11 +292,10 @@ auto waybar::modules::Wireplumber::update() -> void {
     }
 
     if (!tooltip_format.empty()) {
-      label_.set_tooltip_text(
-          fmt::format(fmt::runtime(tooltip_format), fmt::arg("node_name", node_name_),
-                      fmt::arg("volume", volume_), fmt::arg("icon", getIcon(volume_))));
+      setTooltipText(fmt::format(fmt::runtime(tooltip_format), fmt::arg("node_name", node_name_),
+                                 fmt::arg("volume", volume_), fmt::arg("icon", getIcon(volume_))));
     } else {
-      label_.set_tooltip_text(node_name_);
+      setTooltipText(node_name_);
     }
   }
 
@@ -15,11 +15,11 @@
 #include <sstream>
 #include <utility>
 
-#include "gdkmm/general.h"
 #include "glibmm/error.h"
-#include "glibmm/fileutils.h"
 #include "glibmm/refptr.h"
+#include "util/desktop_index.hpp"
 #include "util/format.hpp"
+#include "util/icon_cache.hpp"
 #include "util/string.hpp"
 
 namespace waybar::modules::wlr {
@@ -53,15 +53,6 @@ static std::vector<std::string> search_prefix() {
   return prefixes;
 }
 
-static Glib::RefPtr<Gdk::Pixbuf> load_icon_from_file(std::string icon_path, int size) {
-  try {
-    auto pb = Gdk::Pixbuf::create_from_file(icon_path, size, size);
-    return pb;
-  } catch (...) {
-    return {};
-  }
-}
-
 static Glib::RefPtr<Gio::DesktopAppInfo> get_app_info_by_name(const std::string &app_id) {
   static std::vector<std::string> prefixes = search_prefix();
 
@@ -87,7 +78,15 @@ static Glib::RefPtr<Gio::DesktopAppInfo> get_app_info_by_name(const std::string
   return {};
 }
 
-Glib::RefPtr<Gio::DesktopAppInfo> get_desktop_app_info(const std::string &app_id) {
+static Glib::RefPtr<Gio::DesktopAppInfo> find_desktop_app_info(const std::string &app_id) {
+  // Usually found in the persistent index, without probing every data dir
+  if (auto entry = util::DesktopIndex::inst().find(app_id)) {
+    auto app_info = Gio::DesktopAppInfo::create_from_filename(entry->path);
+    if (app_info) {
+      return app_info;
+    }
+  }
+
   auto app_info = get_app_info_by_name(app_id);
   if (app_info) {
     return app_info;
@@ -120,6 +119,12 @@ Glib::RefPtr<Gio::DesktopAppInfo> get_desktop_app_info(const std::string &app_id
   return get_app_info_by_name(desktop_file);
 }
 
+/* Cached across tasks and bars, every window of an application resolves the same entry */
+Glib::RefPtr<Gio::DesktopAppInfo> get_desktop_app_info(const std::string &app_id) {
+  return util::IconCache::inst().appInfo(app_id,
+                                         [&app_id] { return find_desktop_app_info(app_id); });
+}
+
 void Task::set_app_info_from_app_id_list(const std::string &app_id_list) {
   std::string app_id;
   std::istringstream stream(app_id_list);
@@ -161,12 +166,13 @@ static std::string get_icon_name_from_icon_theme(const Glib::RefPtr<Gtk::IconThe
   return "";
 }
 
-bool Task::image_load_icon(Gtk::Image &image, const Glib::RefPtr<Gtk::IconTheme> &icon_theme,
+bool Task::image_load_icon(Gtk::Image &image, const std::string &icon_theme,
                            Glib::RefPtr<Gio::DesktopAppInfo> app_info, int size) {
+  auto &icon_cache = util::IconCache::inst();
   std::string ret_icon_name = "unknown";
   if (app_info) {
-    std::string icon_name =
-        get_icon_name_from_icon_theme(icon_theme, app_info->get_startup_wm_class());
+    std::string icon_name = get_icon_name_from_icon_theme(icon_cache.theme(icon_theme),
+                                                          app_info->get_startup_wm_class());
     if (!icon_name.empty()) {
       ret_icon_name = icon_name;
     } else {
@@ -176,30 +182,22 @@ bool Task::image_load_icon(Gtk::Image &image, const Glib::RefPtr<Gtk::IconTheme>
     }
   }
 
-  Glib::RefPtr<Gdk::Pixbuf> pixbuf;
-  auto scaled_icon_size = size * image.get_scale_factor();
-
-  try {
-    pixbuf = icon_theme->load_icon(ret_icon_name, scaled_icon_size, Gtk::ICON_LOOKUP_FORCE_SIZE);
-  } catch (...) {
-    if (Glib::file_test(ret_icon_name, Glib::FILE_TEST_EXISTS))
-      pixbuf = load_icon_from_file(ret_icon_name, scaled_icon_size);
-    else
-      pixbuf = {};
+  auto found = icon_cache.loadIcon(icon_request_, icon_theme, ret_icon_name, size,
+                                  image.get_scale_factor(),
+                                  [&image](const Cairo::RefPtr<Cairo::Surface> &surface) {
+                                    image.set_size_request(-1, -1);
+                                    if (surface) {
+                                      image.set(surface);
+                                    } else {
+                                      image.clear();
+                                    }
+                                  });
+  if (found && icon_request_.pending()) {
+    // Keep the room of the icon while it is decoded, the button doesn't resize when it shows up
+    image.clear();
+    image.set_size_request(size, size);
   }
-
-  if (pixbuf) {
-    if (pixbuf->get_width() != scaled_icon_size) {
-      int width = scaled_icon_size * pixbuf->get_width() / pixbuf->get_height();
-      pixbuf = pixbuf->scale_simple(width, scaled_icon_size, Gdk::InterpType::INTERP_BILINEAR);
-    }
-    auto surface = Gdk::Cairo::create_surface_from_pixbuf(pixbuf, image.get_scale_factor(),
-                                                          image.get_window());
-    image.set(surface);
-    return true;
-  }
-
-  return false;
+  return found;
 }
 
 /* Task class implementation */
@@ -732,20 +730,16 @@ Taskbar::Taskbar(const std::string &id, const waybar::Bar &bar, const Json::Valu
     for (auto &c : config_["icon-theme"]) {
       auto it_name = c.asString();
 
-      auto it = Gtk::IconTheme::create();
-      it->set_custom_theme(it_name);
       spdlog::debug("Use custom icon theme: {}", it_name);
 
-      icon_themes_.push_back(it);
+      icon_themes_.push_back(it_name);
     }
   } else if (config_["icon-theme"].isString()) {
     auto it_name = config_["icon-theme"].asString();
 
-    auto it = Gtk::IconTheme::create();
-    it->set_custom_theme(it_name);
     spdlog::debug("Use custom icon theme: {}", it_name);
 
-    icon_themes_.push_back(it);
+    icon_themes_.push_back(it_name);
   }
 
   // Load ignore-list
@@ -764,7 +758,8 @@ Taskbar::Taskbar(const std::string &id, const waybar::Bar &bar, const Json::Valu
     }
   }
 
-  icon_themes_.push_back(Gtk::IconTheme::get_default());
+  // The default theme
+  icon_themes_.emplace_back();
 }
 
 Taskbar::~Taskbar() {
@@ -877,7 +872,7 @@ bool Taskbar::all_outputs() const {
   return config_["all-outputs"].isBool() && config_["all-outputs"].asBool();
 }
 
-const std::vector<Glib::RefPtr<Gtk::IconTheme>> &Taskbar::icon_themes() const {
+const std::vector<std::string> &Taskbar::icon_themes() const {
   return icon_themes_;
 }
 
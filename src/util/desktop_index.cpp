@@ -0,0 +1,295 @@
+#include "util/desktop_index.hpp"
+
+#include <fcntl.h>
+#include <glibmm/miscutils.h>
+#include <spdlog/spdlog.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <charconv>
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+
+namespace fs = std::filesystem;
+
+namespace waybar::util {
+
+namespace {
+
+constexpr std::string_view HEADER = "waybar desktop index 1\n";
+
+/* Modification time of a directory in ns, -1 if it doesn't exist */
+int64_t modificationTime(const std::string& path) {
+  struct stat st;
+  if (stat(path.c_str(), &st) != 0) {
+    return -1;
+  }
+  return static_cast<int64_t>(st.st_mtim.tv_sec) * 1000000000 + st.st_mtim.tv_nsec;
+}
+
+/* Split `line` at tabs into `fields`, returns the number of fields found */
+size_t split(std::string_view line, std::string_view* fields, size_t count) {
+  size_t n = 0;
+  while (n < count) {
+    auto tab = line.find('\t');
+    fields[n++] = line.substr(0, tab);
+    if (tab == std::string_view::npos) {
+      break;
+    }
+    line.remove_prefix(tab + 1);
+  }
+  return n;
+}
+
+std::string_view trim(std::string_view s) {
+  auto begin = s.find_first_not_of(" \t\r");
+  if (begin == std::string_view::npos) {
+    return {};
+  }
+  return s.substr(begin, s.find_last_not_of(" \t\r") - begin + 1);
+}
+
+/* Whether a value can be stored as a field of the index */
+bool isField(std::string_view value) { return value.find_first_of("\t\n") == std::string::npos; }
+
+struct DesktopFile {
+  std::string icon;
+  std::string wm_class;
+};
+
+/* Read the keys of the main group of a desktop file, a real parser is not needed for two keys */
+DesktopFile readDesktopFile(const fs::path& path) {
+  DesktopFile file;
+  std::ifstream stream(path);
+  std::string line;
+  bool main_group = false;
+  while (std::getline(stream, line)) {
+    if (!line.empty() && line[0] == '[') {
+      if (main_group) {
+        break;
+      }
+      main_group = line.compare(0, 15, "[Desktop Entry]") == 0;
+      continue;
+    }
+    auto equal = line.find('=');
+    if (!main_group || equal == std::string::npos) {
+      continue;
+    }
+    auto key = trim(std::string_view(line).substr(0, equal));
+    auto value = trim(std::string_view(line).substr(equal + 1));
+    if (key == "Icon") {
+      file.icon = value;
+    } else if (key == "StartupWMClass") {
+      file.wm_class = value;
+    }
+  }
+  return file;
+}
+
+/* Append the directories and the desktop files under `dir` to the index */
+void scan(const fs::path& dir, std::string& out) {
+  out += "D\t" + std::to_string(modificationTime(dir)) + '\t' + dir.string() + '\n';
+  std::error_code ec;
+  std::vector<fs::path> subdirs;
+  for (const auto& entry : fs::directory_iterator(dir, ec)) {
+    const auto& path = entry.path();
+    // Symbolic links to directories are not followed, they could loop
+    if (entry.is_directory(ec) && !entry.is_symlink(ec)) {
+      subdirs.push_back(path);
+      continue;
+    }
+    if (path.extension() != ".desktop") {
+      continue;
+    }
+    auto file = readDesktopFile(path);
+    auto id = path.stem().string();
+    if (!isField(id) || !isField(path.string()) || !isField(file.icon)) {
+      continue;
+    }
+    auto fields = path.string() + '\t' + file.icon;
+    out += "I\t" + id + '\t' + fields + '\n';
+    if (id.compare(0, 8, "org.kde.") == 0) {
+      out += "I\t" + id.substr(8) + '\t' + fields + '\n';
+    }
+    if (!file.wm_class.empty() && isField(file.wm_class)) {
+      out += "W\t" + file.wm_class + '\t' + fields + '\n';
+    }
+  }
+  // Files directly in a directory take precedence over the ones of its subdirectories
+  for (const auto& subdir : subdirs) {
+    scan(subdir, out);
+  }
+}
+
+std::string joinDirs(const std::vector<std::string>& dirs) {
+  std::string joined;
+  for (const auto& dir : dirs) {
+    if (!joined.empty()) {
+      joined += ':';
+    }
+    joined += dir;
+  }
+  return joined;
+}
+
+}  // namespace
+
+DesktopIndex& DesktopIndex::inst() {
+  // Intentionally leaked like the Scheduler, modules may still use it during static destruction
+  static auto index = [] {
+    auto data_dirs = Glib::get_system_data_dirs();
+    data_dirs.insert(data_dirs.begin(), Glib::get_user_data_dir());
+    auto cache_file = fs::path(Glib::get_user_cache_dir()) / "waybar" / "desktop-index";
+    return new DesktopIndex(std::move(data_dirs), cache_file.string());
+  }();
+  return *index;
+}
+
+DesktopIndex::DesktopIndex(std::vector<std::string> data_dirs, std::string cache_file)
+    : data_dirs_(std::move(data_dirs)), cache_file_(std::move(cache_file)) {}
+
+DesktopIndex::~DesktopIndex() { reset(); }
+
+std::optional<DesktopIndex::Entry> DesktopIndex::find(const std::string& app_id) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (!valid_) {
+    load();
+  }
+  auto it = ids_.find(app_id);
+  if (it == ids_.end()) {
+    it = wm_classes_.find(app_id);
+    if (it == wm_classes_.end()) {
+      return std::nullopt;
+    }
+  }
+  return Entry{std::string(it->second.path), std::string(it->second.icon)};
+}
+
+void DesktopIndex::invalidate() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  valid_ = false;
+}
+
+void DesktopIndex::reset() {
+  ids_.clear();
+  wm_classes_.clear();
+  data_ = {};
+  built_.clear();
+  if (map_ != nullptr) {
+    munmap(map_, map_size_);
+    map_ = nullptr;
+  }
+}
+
+void DesktopIndex::load() {
+  reset();
+  valid_ = true;
+
+  int fd = open(cache_file_.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd >= 0) {
+    struct stat st;
+    if (fstat(fd, &st) == 0 && st.st_size > 0) {
+      map_size_ = st.st_size;
+      map_ = mmap(nullptr, map_size_, PROT_READ, MAP_PRIVATE, fd, 0);
+      if (map_ == MAP_FAILED) {
+        map_ = nullptr;
+      }
+    }
+    close(fd);
+  }
+  if (map_ != nullptr) {
+    data_ = std::string_view(static_cast<const char*>(map_), map_size_);
+    if (parse(data_, true)) {
+      return;
+    }
+    spdlog::debug("Desktop index {} is outdated", cache_file_);
+    reset();
+  }
+
+  build();
+  data_ = built_;
+  parse(data_, false);
+  save();
+}
+
+bool DesktopIndex::parse(std::string_view data, bool validate) {
+  if (data.substr(0, HEADER.size()) != HEADER) {
+    return false;
+  }
+  data.remove_prefix(HEADER.size());
+  // Changes made while the index was built may not have changed the (coarse) modification time
+  // of the directories yet, those younger than the index by less than a second are not trusted
+  int64_t racy = INT64_MAX;
+  bool valid = true;
+  while (!data.empty()) {
+    auto eol = data.find('\n');
+    auto line = data.substr(0, eol);
+    data.remove_prefix(eol == std::string_view::npos ? data.size() : eol + 1);
+
+    std::string_view fields[4];
+    auto count = split(line, fields, 4);
+    if (fields[0] == "I" && count == 4) {
+      ids_.emplace(fields[1], View{fields[2], fields[3]});
+    } else if (fields[0] == "W" && count == 4) {
+      wm_classes_.emplace(fields[1], View{fields[2], fields[3]});
+    } else if (fields[0] == "D" && count == 3) {
+      int64_t mtime = 0;
+      std::from_chars(fields[1].data(), fields[1].data() + fields[1].size(), mtime);
+      valid = valid && mtime == modificationTime(std::string(fields[2])) && mtime < racy;
+    } else if (fields[0] == "T" && count == 2) {
+      int64_t built = 0;
+      std::from_chars(fields[1].data(), fields[1].data() + fields[1].size(), built);
+      racy = built - 1000000000;
+    } else if (fields[0] == "S" && count == 2) {
+      valid = valid && fields[1] == joinDirs(data_dirs_);
+    } else {
+      valid = false;
+    }
+  }
+  if (validate && !valid) {
+    ids_.clear();
+    wm_classes_.clear();
+  }
+  return !validate || valid;
+}
+
+void DesktopIndex::build() {
+  auto start = std::chrono::steady_clock::now();
+  auto now = std::chrono::system_clock::now().time_since_epoch();
+  built_ = HEADER;
+  built_ += "S\t" + joinDirs(data_dirs_) + '\n';
+  built_ += "T\t" + std::to_string(std::chrono::nanoseconds(now).count()) + '\n';
+  for (const auto& data_dir : data_dirs_) {
+    scan(fs::path(data_dir) / "applications", built_);
+  }
+  spdlog::debug("Built the desktop index in {}us",
+                std::chrono::duration_cast<std::chrono::microseconds>(
+                    std::chrono::steady_clock::now() - start)
+                    .count());
+}
+
+void DesktopIndex::save() const {
+  std::error_code ec;
+  fs::create_directories(fs::path(cache_file_).parent_path(), ec);
+  // Written aside and renamed, other instances may be mapping the current index
+  auto tmp = cache_file_ + '.' + std::to_string(getpid());
+  {
+    std::ofstream stream(tmp, std::ios::binary | std::ios::trunc);
+    stream.write(built_.data(), built_.size());
+    if (!stream) {
+      spdlog::debug("Can't write the desktop index to {}", tmp);
+      fs::remove(tmp, ec);
+      return;
+    }
+  }
+  fs::rename(tmp, cache_file_, ec);
+  if (ec) {
+    spdlog::debug("Can't save the desktop index to {}: {}", cache_file_, ec.message());
+    fs::remove(tmp, ec);
+  }
+}
+
+}  // namespace waybar::util
@@ -0,0 +1,114 @@
+#include "util/format_template.hpp"
+
+#include <algorithm>
+#include <iterator>
+
+namespace waybar::util {
+
+FormatTemplate::FormatTemplate(std::string format) : format_(std::move(format)) { parse(); }
+
+void FormatTemplate::parse() {
+  std::string text;
+  int next_index = 0;
+  size_t i = 0;
+  while (i < format_.size()) {
+    char c = format_[i];
+    if (c == '}') {
+      if (i + 1 >= format_.size() || format_[i + 1] != '}') {
+        throw fmt::format_error("unmatched '}' in format string");
+      }
+      text += '}';
+      i += 2;
+      continue;
+    }
+    if (c != '{') {
+      text += c;
+      ++i;
+      continue;
+    }
+    if (i + 1 < format_.size() && format_[i + 1] == '{') {
+      text += '{';
+      i += 2;
+      continue;
+    }
+
+    auto close = format_.find('}', i);
+    if (close == std::string::npos) {
+      throw fmt::format_error("invalid format string");
+    }
+    auto field = std::string_view(format_).substr(i + 1, close - i - 1);
+    if (field.find('{') != std::string_view::npos) {
+      // Nested fields (e.g. a dynamic width) need the other arguments, let fmt handle it all
+      nested_ = true;
+      ops_.clear();
+      return;
+    }
+    if (!text.empty()) {
+      ops_.push_back({std::move(text), false, {}, 0});
+      text.clear();
+    }
+
+    auto colon = field.find(':');
+    auto id = field.substr(0, colon);
+    Op op{colon == std::string_view::npos ? "{}" : fmt::format("{{{}}}", field.substr(colon)),
+          true,
+          {},
+          0};
+    if (id.empty()) {
+      op.index = next_index++;
+    } else if (std::all_of(id.begin(), id.end(), [](char d) { return d >= '0' && d <= '9'; })) {
+      op.index = std::stoi(std::string(id));
+    } else {
+      op.name = id;
+    }
+    ops_.push_back(std::move(op));
+    i = close + 1;
+  }
+  if (!text.empty()) {
+    ops_.push_back({std::move(text), false, {}, 0});
+  }
+}
+
+bool FormatTemplate::uses(std::string_view name) const {
+  if (nested_) {
+    // Not parsed, look for the name in the raw string instead
+    return format_.find(name) != std::string::npos;
+  }
+  return std::any_of(ops_.begin(), ops_.end(),
+                     [name](const Op& op) { return op.field && op.name == name; });
+}
+
+std::string FormatTemplate::vrender(fmt::format_args args) const {
+  if (nested_) {
+    return fmt::vformat(format_, args);
+  }
+  if (ops_.size() == 1 && !ops_[0].field) {
+    return ops_[0].text;
+  }
+  buffer_.clear();
+  for (const auto& op : ops_) {
+    if (!op.field) {
+      buffer_.append(op.text.data(), op.text.data() + op.text.size());
+      continue;
+    }
+    auto arg = op.name.empty() ? args.get(op.index) : args.get(fmt::string_view(op.name));
+    if (!arg) {
+      throw fmt::format_error("argument not found");
+    }
+    // The field's own format only refers to this argument
+    fmt::vformat_to(std::back_inserter(buffer_), op.text,
+                    fmt::basic_format_args<fmt::format_context>(&arg, 1));
+  }
+  return fmt::to_string(buffer_);
+}
+
+const FormatTemplate& FormatCache::get(const std::string& format) {
+  auto it = templates_.find(format);
+  if (it == templates_.end()) {
+    // Formats come from the config, only a handful per module
+    it = templates_.try_emplace(format, format).first;
+  }
+  return it->second;
+}
+
+}  // namespace waybar::util
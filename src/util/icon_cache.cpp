@@ -0,0 +1,264 @@
+#include "util/icon_cache.hpp"
+
+#include <fmt/format.h>
+#include <gdkmm/general.h>
+#include <glibmm/error.h>
+#include <glibmm/fileutils.h>
+#include <glibmm/miscutils.h>
+#include <spdlog/spdlog.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+
+#include <filesystem>
+#include <string_view>
+
+#include "util/desktop_index.hpp"
+
+namespace waybar::util {
+
+IconCache& IconCache::inst() {
+  // Intentionally leaked like the Scheduler, modules may still use it during static destruction
+  static auto cache = new IconCache();
+  return *cache;
+}
+
+IconCache::IconCache() {
+  watch();
+  Gtk::IconTheme::get_default()->signal_changed().connect([this] { clear(); });
+}
+
+void IconCache::watch() {
+  inotify_fd_ = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+  if (inotify_fd_ < 0) {
+    spdlog::warn("Icon cache: can't watch the XDG data dirs, changes need a restart");
+    return;
+  }
+  const uint32_t mask =
+      IN_CREATE | IN_DELETE | IN_CLOSE_WRITE | IN_MOVED_FROM | IN_MOVED_TO | IN_ONLYDIR;
+  auto data_dirs = Glib::get_system_data_dirs();
+  data_dirs.insert(data_dirs.begin(), Glib::get_user_data_dir());
+  for (const auto& data_dir : data_dirs) {
+    std::filesystem::path dir(data_dir);
+    // The data dir itself catches `applications` or `icons` being created
+    int wd = inotify_add_watch(inotify_fd_, dir.c_str(), mask);
+    if (wd >= 0) {
+      data_dir_watches_.insert(wd);
+    }
+    inotify_add_watch(inotify_fd_, (dir / "applications").c_str(), mask);
+    // Installing icons updates the icon-theme.cache or the index of each theme
+    inotify_add_watch(inotify_fd_, (dir / "icons").c_str(), mask);
+    std::error_code ec;
+    for (const auto& theme : std::filesystem::directory_iterator(dir / "icons", ec)) {
+      inotify_add_watch(inotify_fd_, theme.path().c_str(), mask);
+    }
+  }
+  Glib::signal_io().connect(sigc::mem_fun(*this, &IconCache::onChange), inotify_fd_,
+                            Glib::IO_IN | Glib::IO_ERR | Glib::IO_HUP);
+}
+
+bool IconCache::onChange(Glib::IOCondition cond) {
+  if (!(cond & Glib::IO_IN)) {
+    spdlog::warn("Icon cache: lost the watch on the XDG data dirs");
+    close(inotify_fd_);
+    inotify_fd_ = -1;
+    return false;
+  }
+  // Anything written to the data dirs themselves (e.g. recently-used.xbel in ~/.local/share) is
+  // reported too, only their `applications` and `icons` entries matter
+  bool changed = false;
+  alignas(struct inotify_event) char buffer[4096];
+  ssize_t len;
+  while ((len = read(inotify_fd_, buffer, sizeof(buffer))) > 0) {
+    for (ssize_t pos = 0; pos < len;) {
+      const auto* event = reinterpret_cast<const struct inotify_event*>(buffer + pos);
+      pos += sizeof(struct inotify_event) + event->len;
+      if (data_dir_watches_.count(event->wd) == 0 || event->len == 0) {
+        // Within a watched subdir, about a data dir itself, or IN_Q_OVERFLOW (events were lost)
+        changed = true;
+        continue;
+      }
+      std::string_view name(event->name);
+      if (name == "applications" || name == "icons") {
+        changed = true;
+      }
+    }
+  }
+  if (!changed) {
+    return true;
+  }
+  spdlog::debug("Icon cache: XDG data dirs changed, dropping cached icons");
+  clear();
+  return true;
+}
+
+void IconCache::clear() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  ++generation_;
+  app_infos_.clear();
+  icon_names_.clear();
+  surfaces_.clear();
+  decoding_.clear();
+  for (auto& [name, theme] : themes_) {
+    theme->rescan_if_needed();
+  }
+  DesktopIndex::inst().invalidate();
+}
+
+IconCache::AppInfo IconCache::appInfo(const std::string& key,
+                                      const std::function<AppInfo()>& resolve) {
+  uint64_t generation;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (const auto* app_info = app_infos_.get(key)) {
+      return *app_info;
+    }
+    generation = generation_;
+  }
+  auto app_info = resolve();
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (generation == generation_) {
+    app_infos_.put(key, app_info);
+  }
+  return app_info;
+}
+
+std::string IconCache::iconName(const std::string& key,
+                                const std::function<std::string()>& resolve) {
+  uint64_t generation;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (const auto* name = icon_names_.get(key)) {
+      return *name;
+    }
+    generation = generation_;
+  }
+  auto name = resolve();
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (generation == generation_) {
+    icon_names_.put(key, name);
+  }
+  return name;
+}
+
+Glib::RefPtr<Gtk::IconTheme> IconCache::theme(const std::string& name) {
+  if (name.empty()) {
+    return Gtk::IconTheme::get_default();
+  }
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto& theme = themes_[name];
+  if (!theme) {
+    theme = Gtk::IconTheme::create();
+    theme->set_custom_theme(name);
+  }
+  return theme;
+}
+
+namespace {
+
+/* Icons that are not square keep their aspect ratio, with the requested height */
+Glib::RefPtr<Gdk::Pixbuf> fitHeight(Glib::RefPtr<Gdk::Pixbuf> pixbuf, int size) {
+  if (pixbuf && pixbuf->get_width() != size) {
+    int width = size * pixbuf->get_width() / pixbuf->get_height();
+    pixbuf = pixbuf->scale_simple(width, size, Gdk::InterpType::INTERP_BILINEAR);
+  }
+  return pixbuf;
+}
+
+}  // namespace
+
+bool IconCache::loadIcon(IconRequest& request, const std::string& theme_name,
+                         const std::string& icon, int size, int scale,
+                         std::function<void(Cairo::RefPtr<Cairo::Surface>)> done) {
+  auto key = fmt::format("{}\n{}\n{}@{}", theme_name, icon, size, scale);
+  uint64_t generation;
+  std::shared_ptr<Decoding> decoding;
+  {
+    std::unique_lock lock(mutex_);
+    if (const auto* cached = surfaces_.get(key)) {
+      auto surface = *cached;
+      lock.unlock();
+      if (!surface) {
+        return false;
+      }
+      request.cancel();
+      done(surface);
+      return true;
+    }
+    generation = generation_;
+    if (auto it = decoding_.find(key); it != decoding_.end()) {
+      decoding = it->second;
+    }
+  }
+
+  // Only find the file here, GTK can't be used from the workers
+  auto scaled_size = size * scale;
+  std::string path;
+  Glib::RefPtr<Gdk::Pixbuf> builtin;
+  auto info = theme(theme_name)->lookup_icon(icon, scaled_size, Gtk::ICON_LOOKUP_FORCE_SIZE);
+  if (info) {
+    path = info.get_filename();
+    if (path.empty()) {
+      // Built into the resources of GTK, already in memory
+      try {
+        builtin = info.load_icon();
+      } catch (const Glib::Error& e) {
+        spdlog::warn("Failed to load icon {}: {}", icon, std::string(e.what()));
+      }
+    }
+  } else if (Glib::file_test(icon, Glib::FILE_TEST_EXISTS)) {
+    path = icon;
+  } else {
+    store(key, generation, {});
+    return false;
+  }
+
+  auto finish = [this, key, generation, scale,
+                 done = std::move(done)](Glib::RefPtr<Gdk::Pixbuf> pixbuf) {
+    Cairo::RefPtr<Cairo::Surface> surface;
+    if (pixbuf) {
+      // Not tied to a window so that the surface can be shared by all the bars
+      surface =
+          Gdk::Cairo::create_surface_from_pixbuf(pixbuf, scale, Glib::RefPtr<Gdk::Window>());
+    }
+    // Files that can't be decoded are remembered as well
+    store(key, generation, surface);
+    done(surface);
+  };
+  if (path.empty()) {
+    request.cancel();
+    finish(fitHeight(builtin, scaled_size));
+    return true;
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!decoding) {
+      decoding = std::make_shared<Decoding>();
+      if (generation == generation_) {
+        decoding_[key] = decoding;
+      }
+    }
+  }
+  request.start(
+      [decoding, path, scaled_size] {
+        // Windows of the same application often open together, decode their icon only once
+        std::call_once(decoding->once, [&] {
+          decoding->pixbuf =
+              fitHeight(Gdk::Pixbuf::create_from_file(path, scaled_size, scaled_size), scaled_size);
+        });
+        return decoding->pixbuf;
+      },
+      std::move(finish));
+  return true;
+}
+
+void IconCache::store(const std::string& key, uint64_t generation,
+                      Cairo::RefPtr<Cairo::Surface> surface) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (generation == generation_) {
+    surfaces_.put(key, std::move(surface));
+    decoding_.erase(key);
+  }
+}
+
+}  // namespace waybar::util
@@ -0,0 +1,85 @@
+#include "util/icon_loader.hpp"
+
+#include <glibmm/error.h>
+#include <spdlog/spdlog.h>
+
+#include <algorithm>
+
+#ifdef __linux__
+#include <sys/prctl.h>
+#endif
+
+namespace waybar::util {
+
+IconLoader& IconLoader::inst() {
+  // Intentionally leaked like the Scheduler, the workers are never joined
+  static auto loader = new IconLoader();
+  return *loader;
+}
+
+IconLoader::IconLoader() {
+  finished_.connect(sigc::mem_fun(*this, &IconLoader::finish));
+  // A couple of icons at once is plenty, don't compete with the applications being started
+  auto count = std::clamp(std::thread::hardware_concurrency() / 2, 1U, 2U);
+  for (unsigned i = 0; i < count; ++i) {
+    threads_.emplace_back([this] { run(); });
+  }
+}
+
+IconLoader::id_t IconLoader::post(std::function<Pixbuf()> decode,
+                                  std::function<void(Pixbuf)> done) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto id = next_id_++;
+  pending_.emplace(id, std::move(done));
+  jobs_.emplace_back(id, std::move(decode));
+  condvar_.notify_one();
+  return id;
+}
+
+void IconLoader::cancel(id_t id) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  pending_.erase(id);
+}
+
+void IconLoader::run() {
+#ifdef __linux__
+  prctl(PR_SET_NAME, "waybar-icons");
+#endif
+  std::unique_lock lock(mutex_);
+  while (true) {
+    condvar_.wait(lock, [this] { return !jobs_.empty(); });
+    auto [id, decode] = std::move(jobs_.front());
+    jobs_.pop_front();
+    if (pending_.count(id) == 0) {
+      // Cancelled while queued, e.g. replaced by a newer icon
+      continue;
+    }
+    lock.unlock();
+    Pixbuf pixbuf;
+    try {
+      pixbuf = decode();
+    } catch (const Glib::Error& e) {
+      spdlog::warn("Failed to load icon: {}", std::string(e.what()));
+    } catch (const std::exception& e) {
+      spdlog::warn("Failed to load icon: {}", e.what());
+    }
+    finished_.emit(id, std::move(pixbuf));
+    lock.lock();
+  }
+}
+
+void IconLoader::finish(id_t id, Pixbuf pixbuf) {
+  std::function<void(Pixbuf)> done;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = pending_.find(id);
+    if (it == pending_.end()) {
+      return;
+    }
+    done = std::move(it->second);
+    pending_.erase(it);
+  }
+  done(std::move(pixbuf));
+}
+
+}  // namespace waybar::util
@@ -0,0 +1,114 @@
+#include "util/json.hpp"
+
+#include <vector>
+
+namespace waybar::util {
+
+namespace {
+
+/* Position after the string starting at `pos` */
+size_t skipString(std::string_view data, size_t pos) {
+  for (++pos; pos < data.size(); ++pos) {
+    if (data[pos] == '\\') {
+      ++pos;
+    } else if (data[pos] == '"') {
+      return pos + 1;
+    }
+  }
+  return data.size();
+}
+
+/* Position after the value starting at `pos` */
+size_t skipValue(std::string_view data, size_t pos) {
+  int depth = 0;
+  while (pos < data.size()) {
+    char c = data[pos];
+    if (c == '"') {
+      pos = skipString(data, pos);
+      if (depth == 0) {
+        return pos;
+      }
+      continue;
+    }
+    if (c == '{' || c == '[') {
+      ++depth;
+    } else if (c == '}' || c == ']') {
+      if (depth == 0) {
+        return pos;  // end of a number or literal ending its container
+      }
+      if (--depth == 0) {
+        return pos + 1;
+      }
+    } else if (c == ',' && depth == 0) {
+      return pos;
+    }
+    ++pos;
+  }
+  return pos;
+}
+
+size_t skipSpaces(std::string_view data, size_t pos) {
+  while (pos < data.size() && isspace(static_cast<unsigned char>(data[pos]))) {
+    ++pos;
+  }
+  return pos;
+}
+
+}  // namespace
+
+// Scans the document once, copying everything but the skipped members. Malformed documents are
+// copied as they come, the reader reports the error.
+std::string JsonParser::skipMembers(std::string_view data) const {
+  std::string out;
+  out.reserve(data.size());
+  // Whether each enclosing container is an object
+  std::vector<bool> objects;
+  bool expect_key = false;
+  size_t pos = 0;
+  while (pos < data.size()) {
+    char c = data[pos];
+    if (c == '"') {
+      auto end = skipString(data, pos);
+      if (expect_key && end - pos >= 2 && skipped_.count(data.substr(pos + 1, end - pos - 2)) > 0) {
+        auto colon = data.find(':', end);
+        if (colon == std::string_view::npos) {
+          out.append(data.substr(pos));
+          break;
+        }
+        pos = skipSpaces(data, skipValue(data, skipSpaces(data, colon + 1)));
+        if (pos < data.size() && data[pos] == ',') {
+          ++pos;
+        } else {
+          // Last member, drop the comma after the previous one
+          while (!out.empty() && isspace(static_cast<unsigned char>(out.back()))) {
+            out.pop_back();
+          }
+          if (!out.empty() && out.back() == ',') {
+            out.pop_back();
+          }
+        }
+        continue;
+      }
+      out.append(data.substr(pos, end - pos));
+      expect_key = false;
+      pos = end;
+      continue;
+    }
+    if (c == '{' || c == '[') {
+      objects.push_back(c == '{');
+      expect_key = c == '{';
+    } else if (c == '}' || c == ']') {
+      if (!objects.empty()) {
+        objects.pop_back();
+      }
+      expect_key = false;
+    } else if (c == ',') {
+      expect_key = !objects.empty() && objects.back();
+    }
+    out.push_back(c);
+    ++pos;
+  }
+  return out;
+}
+
+}  // namespace waybar::util
@@ -2,31 +2,89 @@
 
 #include <spdlog/spdlog.h>
 
-#include <regex>
+#include <cctype>
+#include <cstring>
 
 namespace waybar::util {
-std::string rewriteTitle(const std::string& title, const Json::Value& rules) {
-  if (!rules.isObject()) {
-    return title;
+
+namespace {
+
+/* Titles remembered with their rewritten form */
+constexpr size_t CACHE_SIZE = 64;
+
+/* Literal text that a title must start with to fully match `pattern` (ECMAScript syntax) */
+std::string literalPrefix(const std::string& pattern) {
+  // Each alternative may start with something else
+  if (pattern.find('|') != std::string::npos) {
+    return "";
   }
+  std::string prefix;
+  for (size_t i = pattern.rfind('^', 0) == 0 ? 1 : 0; i < pattern.size(); ++i) {
+    char c = pattern[i];
+    if (c == '\\') {
+      // Escaped punctuation is a literal, letters are classes or assertions (\d, \b, ...)
+      if (i + 1 >= pattern.size() || !std::ispunct(static_cast<unsigned char>(pattern[i + 1]))) {
+        break;
+      }
+      c = pattern[++i];
+    } else if (std::strchr("^$.|?*+()[]{}", c) != nullptr) {
+      break;
+    }
+    auto next = i + 1 < pattern.size() ? pattern[i + 1] : '\0';
+    if (next == '?' || next == '*' || next == '{') {
+      // The character may not be there
+      break;
+    }
+    prefix += c;
+    if (next == '+') {
+      break;
+    }
+  }
+  return prefix;
+}
 
-  std::string res = title;
+}  // namespace
 
+RewriteRules::RewriteRules(const Json::Value& rules) : cache_(CACHE_SIZE) {
+  if (!rules.isObject()) {
+    return;
+  }
   for (auto it = rules.begin(); it != rules.end(); ++it) {
     if (it.key().isString() && it->isString()) {
       try {
         // malformated regexes will cause an exception.
         // in this case, log error and try the next rule.
-        const std::regex rule{it.key().asString()};
-        if (std::regex_match(title, rule)) {
-          res = std::regex_replace(res, rule, it->asString());
-        }
+        auto pattern = it.key().asString();
+        rules_.push_back({literalPrefix(pattern), std::regex(pattern), it->asString()});
       } catch (const std::regex_error& e) {
         spdlog::error("Invalid rule {}: {}", it.key().asString(), e.what());
       }
     }
   }
+}
+
+std::string RewriteRules::apply(const std::string& title) {
+  if (rules_.empty()) {
+    return title;
+  }
+  if (const auto* cached = cache_.get(title)) {
+    return *cached;
+  }
 
-  return res;
+  std::string res = title;
+  for (const auto& rule : rules_) {
+    if (title.compare(0, rule.prefix.size(), rule.prefix) != 0) {
+      continue;
+    }
+    try {
+      if (std::regex_match(title, rule.regex)) {
+        res = std::regex_replace(res, rule.regex, rule.replacement);
+      }
+    } catch (const std::regex_error& e) {
+      spdlog::error("Rule failed on {}: {}", title, e.what());
+    }
+  }
+  return cache_.put(title, std::move(res));
 }
+
 }  // namespace waybar::util
@@ -1,24 +1,75 @@
 #include <array>
+#include <cstdint>
+#include <cstring>
 #include <string>
+#include <string_view>
 #include <util/sanitize_str.hpp>
-#include <utility>
 
 namespace waybar::util {
+
+namespace {
+
+constexpr const char* SPECIAL_CHARS = "&<>\"'";
+
+/* Escaped form of each byte, empty for bytes kept as is */
+constexpr auto ENTITIES = [] {
+  std::array<std::string_view, 256> entities{};
+  entities['&'] = "&amp;";
+  entities['<'] = "&lt;";
+  entities['>'] = "&gt;";
+  entities['"'] = "&quot;";
+  entities['\''] = "&apos;";
+  return entities;
+}();
+
+}  // namespace
+
 // replaces ``<>&"'`` with their encoded counterparts
 std::string sanitize_string(std::string str) {
-  // note: it's important that '&' is replaced first; therefore we *can't* use std::map
-  const std::pair<char, std::string> replacement_table[] = {
-      {'&', "&amp;"}, {'<', "&lt;"}, {'>', "&gt;"}, {'"', "&quot;"}, {'\'', "&apos;"}};
-  size_t startpoint;
-  for (size_t i = 0; i < (sizeof(replacement_table) / sizeof(replacement_table[0])); ++i) {
-    startpoint = 0;
-    std::pair pair = replacement_table[i];
-    while ((startpoint = str.find(pair.first, startpoint)) != std::string::npos) {
-      str.replace(startpoint, 1, pair.second);
-      startpoint += pair.second.length();
-    }
+  const char* in = str.c_str();
+  // strcspn is vectorized by the libc. It also stops on NUL bytes within the string, which are
+  // copied like any other byte below.
+  size_t pos = std::strcspn(in, SPECIAL_CHARS);
+  if (pos >= str.size()) {
+    // Most titles have nothing to escape
+    return str;
   }
 
-  return str;
+  // First jump from one character to escape to the next to size the result, remembering where
+  // they are. The result is then allocated once, at its exact size, and filled by copying the runs
+  // between them. Only titles with more than MAX_STOPS of them are scanned a second time.
+  constexpr size_t MAX_STOPS = 128;
+  std::array<uint32_t, MAX_STOPS> stops;
+  size_t count = 0;
+  size_t size = str.size();
+  for (size_t i = pos; i < str.size(); i = i + 1 + std::strcspn(in + i + 1, SPECIAL_CHARS)) {
+    if (count < MAX_STOPS) {
+      stops[count] = i;
+    }
+    ++count;
+    const auto& entity = ENTITIES[static_cast<unsigned char>(in[i])];
+    size += entity.empty() ? 0 : entity.size() - 1;
+  }
+  std::string res(size, '\0');
+  char* out = res.data();
+  size_t run = 0;
+  for (size_t n = 0;; ++n) {
+    pos = n < MAX_STOPS ? (n < count ? stops[n] : str.size())
+                        : run + std::strcspn(in + run, SPECIAL_CHARS);
+    memcpy(out, in + run, pos - run);
+    out += pos - run;
+    if (pos >= str.size()) {
+      break;
+    }
+    const auto& entity = ENTITIES[static_cast<unsigned char>(in[pos])];
+    if (entity.empty()) {
+      *out++ = in[pos];
+    } else {
+      memcpy(out, entity.data(), entity.size());
+      out += entity.size();
+    }
+    run = pos + 1;
+  }
+  return res;
 }
 }  // namespace waybar::util
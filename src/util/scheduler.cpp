@@ -0,0 +1,160 @@
+#include "util/scheduler.hpp"
+
+#ifdef __linux__
+#include <sys/prctl.h>
+#endif
+
+namespace waybar::util {
+
+Scheduler& Scheduler::inst() {
+  // Intentionally leaked: modules may unregister their timers during static destruction
+  static auto s = new Scheduler();
+  return *s;
+}
+
+Scheduler::Scheduler() : thread_([this] { run(); }) {}
+
+void Scheduler::add(id_t& id, clock::duration interval, std::function<void()> func,
+                    bool aligned) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  id = next_id_++;
+  auto& entry = timers_[id];
+  entry.interval = interval;
+  entry.aligned = aligned;
+  entry.func = std::move(func);
+  if (aligned) {
+    ++aligned_count_;
+  }
+  schedule(id, entry, clock::now());
+  // Let the scheduler thread update its timer slack
+  condvar_.notify_one();
+}
+
+void Scheduler::remove(id_t id) {
+  std::unique_lock lock(mutex_);
+  // A callback removing its own timer must not wait for itself
+  if (std::this_thread::get_id() != thread_.get_id()) {
+    done_.wait(lock, [this, id] { return running_ != id; });
+  }
+  auto it = timers_.find(id);
+  if (it == timers_.end()) {
+    return;
+  }
+  unschedule(it->second);
+  if (it->second.aligned) {
+    --aligned_count_;
+  }
+  timers_.erase(it);
+}
+
+void Scheduler::wakeUp(id_t id, clock::duration delay) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto it = timers_.find(id);
+  if (it == timers_.end()) {
+    return;
+  }
+  if (running_ == id) {
+    // Run once more after the current invocation
+    it->second.woken = true;
+    it->second.wake_delay = delay;
+    return;
+  }
+  unschedule(it->second);
+  schedule(id, it->second, clock::now() + delay);
+}
+
+void Scheduler::schedule(id_t id, Entry& entry, clock::time_point deadline) {
+  bool earliest = queue_.empty() || deadline < queue_.begin()->first;
+  entry.pos = queue_.emplace(deadline, id);
+  entry.queued = true;
+  if (earliest) {
+    condvar_.notify_one();
+  }
+}
+
+void Scheduler::unschedule(Entry& entry) {
+  if (entry.queued) {
+    queue_.erase(entry.pos);
+    entry.queued = false;
+  }
+}
+
+void Scheduler::resetSlack() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  slack_ = clock::duration::zero();
+  condvar_.notify_one();
+}
+
+void Scheduler::setSlack(clock::duration slack) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (slack > slack_) {
+    slack_ = slack;
+    // Let the scheduler thread apply the new timer slack
+    condvar_.notify_one();
+  }
+}
+
+Scheduler::clock::time_point Scheduler::nextDeadline(const Entry& entry,
+                                                     clock::time_point now) const {
+  if (entry.aligned && entry.interval.count() > 0) {
+    /* difference with projected wakeup time */
+    auto diff = now.time_since_epoch() % entry.interval;
+    return now + entry.interval - diff;
+  }
+  auto deadline = now + entry.interval;
+  if (slack_.count() > 0 && entry.interval >= std::chrono::seconds(1) && entry.interval >= slack_) {
+    /* round to the nearest multiple of the slack to wake up together with the other timers */
+    auto rounded =
+        clock::time_point((deadline.time_since_epoch() + slack_ / 2) / slack_ * slack_);
+    return rounded > now ? rounded : rounded + slack_;
+  }
+  return deadline;
+}
+
+void Scheduler::run() {
+  std::unique_lock lock(mutex_);
+  while (true) {
+#ifdef __linux__
+    // The kernel slack delays every wait of the thread, it would make aligned timers (e.g. the
+    // clock) fire late: keep the default one while there are any
+    auto thread_slack = aligned_count_ > 0 ? clock::duration::zero() : slack_;
+    if (thread_slack_ != thread_slack) {
+      thread_slack_ = thread_slack;
+      // 0 restores the default slack of the thread
+      prctl(PR_SET_TIMERSLACK,
+            std::chrono::duration_cast<std::chrono::nanoseconds>(thread_slack_).count());
+    }
+#endif
+    if (queue_.empty()) {
+      condvar_.wait(lock);
+      continue;
+    }
+    auto next = queue_.begin();
+    if (next->first > clock::now()) {
+      condvar_.wait_until(lock, next->first);
+      continue;
+    }
+    auto id = next->second;
+    auto& entry = timers_.at(id);
+    unschedule(entry);
+
+    // Copy the callback: it is allowed to stop its own timer
+    auto func = entry.func;
+    running_ = id;
+    lock.unlock();
+    func();
+    lock.lock();
+    running_ = 0;
+    done_.notify_all();
+
+    auto it = timers_.find(id);
+    if (it != timers_.end()) {
+      auto now = clock::now();
+      schedule(id, it->second,
+               it->second.woken ? now + it->second.wake_delay : nextDeadline(it->second, now));
+      it->second.woken = false;
+    }
+  }
+}
+
+}  // namespace waybar::util
@@ -0,0 +1,71 @@
+#include "util/sysfs.hpp"
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <cstring>
+
+waybar::util::SysfsDevice::SysfsDevice(const std::string& path)
+    : path_(path), dir_fd_(open(path.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC)) {}
+
+waybar::util::SysfsDevice::~SysfsDevice() {
+  for (const auto& [name, fd] : fds_) {
+    if (fd >= 0) {
+      close(fd);
+    }
+  }
+  if (dir_fd_ >= 0) {
+    close(dir_fd_);
+  }
+}
+
+int waybar::util::SysfsDevice::fd(std::string_view name) {
+  auto it = fds_.find(name);
+  if (it == fds_.end()) {
+    std::string file(name);
+    int fd = dir_fd_ >= 0 ? openat(dir_fd_, file.c_str(), O_RDONLY | O_CLOEXEC) : -1;
+    it = fds_.emplace(std::move(file), fd).first;
+  }
+  return it->second;
+}
+
+bool waybar::util::SysfsDevice::exists(std::string_view name) { return fd(name) >= 0; }
+
+ssize_t waybar::util::SysfsDevice::read(std::string_view name) {
+  int attribute_fd = fd(name);
+  if (attribute_fd < 0) {
+    return -1;
+  }
+  // sysfs regenerates the value on every read from offset 0
+  return pread(attribute_fd, buffer_.data(), buffer_.size(), 0);
+}
+
+std::optional<uint64_t> waybar::util::SysfsDevice::readNumber(std::string_view name) {
+  auto len = read(name);
+  if (len <= 0) {
+    return std::nullopt;
+  }
+  const char* p = buffer_.data();
+  const char* end = p + len;
+  // Some drivers report a signed current while discharging
+  if (*p == '-') {
+    ++p;
+  }
+  if (p == end || *p < '0' || *p > '9') {
+    return std::nullopt;
+  }
+  uint64_t value = 0;
+  for (; p < end && *p >= '0' && *p <= '9'; ++p) {
+    value = value * 10 + (*p - '0');
+  }
+  return value;
+}
+
+std::optional<std::string> waybar::util::SysfsDevice::readString(std::string_view name) {
+  auto len = read(name);
+  if (len < 0) {
+    return std::nullopt;
+  }
+  auto eol = static_cast<const char*>(std::memchr(buffer_.data(), '\n', len));
+  return std::string(buffer_.data(), eol != nullptr ? eol - buffer_.data() : len);
+}
@@ -0,0 +1,210 @@
+#include "util/text_width.hpp"
+
+#include <glib.h>
+
+#include <algorithm>
+#include <vector>
+
+namespace waybar::util {
+
+namespace {
+
+constexpr auto TAG = std::string_view::npos;
+
+struct WidthRange {
+  char32_t first;
+  char32_t last;
+  int width;
+};
+
+/* Ranges of code points not taking exactly one column, built from GLib on first use */
+const std::vector<WidthRange>& widthTable() {
+  static const auto table = [] {
+    std::vector<WidthRange> ranges;
+    auto scan = [&ranges](char32_t from, char32_t to) {
+      for (auto c = from; c <= to; ++c) {
+        // Soft hyphens are only shown at line breaks, labels are single line
+        int width = g_unichar_iszerowidth(c) || c == 0xAD ? 0 : g_unichar_iswide(c) ? 2 : 1;
+        if (width == 1) {
+          continue;
+        }
+        if (!ranges.empty() && ranges.back().last + 1 == c && ranges.back().width == width) {
+          ranges.back().last = c;
+        } else {
+          ranges.push_back({c, c, width});
+        }
+      }
+    };
+    // Besides tags and variation selectors, nothing above the ideographic planes is special
+    scan(0x80, 0x3FFFF);
+    scan(0xE0000, 0xE0FFF);
+    return ranges;
+  }();
+  return table;
+}
+
+/* Decode the code point at `pos` and move past it, invalid bytes are read one by one as U+FFFD */
+char32_t decode(std::string_view text, size_t& pos) {
+  auto byte = static_cast<unsigned char>(text[pos]);
+  if (byte < 0x80) {
+    ++pos;
+    return byte;
+  }
+  size_t len = byte >= 0xF8 ? 0 : byte >= 0xF0 ? 4 : byte >= 0xE0 ? 3 : byte >= 0xC0 ? 2 : 0;
+  if (len == 0 || pos + len > text.size()) {
+    ++pos;
+    return 0xFFFD;
+  }
+  char32_t c = byte & (0x7F >> len);
+  for (size_t i = 1; i < len; ++i) {
+    auto next = static_cast<unsigned char>(text[pos + i]);
+    if ((next & 0xC0) != 0x80) {
+      ++pos;
+      return 0xFFFD;
+    }
+    c = (c << 6) | (next & 0x3F);
+  }
+  pos += len;
+  return c;
+}
+
+bool isRegionalIndicator(char32_t c) { return c >= 0x1F1E6 && c <= 0x1F1FF; }
+bool isEmojiModifier(char32_t c) { return c >= 0x1F3FB && c <= 0x1F3FF; }
+
+/* Move `pos` past the grapheme cluster starting there, returns the width of the cluster */
+size_t nextCluster(std::string_view text, size_t& pos) {
+  auto c = decode(text, pos);
+  size_t width = charWidth(c);
+  // Simplified UAX #29: combining marks, emoji modifiers, ZWJ sequences and flags
+  bool joined = c == 0x200D;
+  bool flag = isRegionalIndicator(c);
+  while (pos < text.size()) {
+    auto next = pos;
+    auto d = decode(text, next);
+    if (!joined && charWidth(d) != 0 && !isEmojiModifier(d) && !(flag && isRegionalIndicator(d))) {
+      break;
+    }
+    joined = d == 0x200D;
+    flag = false;
+    pos = next;
+  }
+  return width;
+}
+
+bool isAscii(std::string_view text) {
+  return std::all_of(text.begin(), text.end(),
+                     [](char c) { return static_cast<unsigned char>(c) < 0x80; });
+}
+
+/**
+ * Call f(begin, end, width) for each grapheme cluster of `text`, until it returns false.
+ * With `markup`, tags are passed with a TAG width and entities as one column.
+ */
+template <typename F>
+void forEachCluster(std::string_view text, bool markup, F f) {
+  for (size_t pos = 0; pos < text.size();) {
+    auto begin = pos;
+    size_t width;
+    if (markup && (text[pos] == '<' || text[pos] == '&')) {
+      width = text[pos] == '<' ? TAG : 1;
+      pos = std::min(text.find(text[pos] == '<' ? '>' : ';', pos), text.size() - 1) + 1;
+    } else {
+      width = nextCluster(text, pos);
+    }
+    if (!f(begin, pos, width)) {
+      return;
+    }
+  }
+}
+
+std::string truncate(std::string_view text, bool markup, size_t width, std::string_view ellipsis) {
+  size_t total = 0;
+  if (markup || !isAscii(text)) {
+    forEachCluster(text, markup, [&total, width](size_t, size_t, size_t w) {
+      total += w == TAG ? 0 : w;
+      return total <= width;
+    });
+  } else {
+    total = text.size();
+  }
+  if (total <= width) {
+    return std::string(text);
+  }
+
+  auto ellipsis_width = textWidth(ellipsis);
+  bool show_ellipsis = width > 0 && width >= ellipsis_width;
+  size_t budget = show_ellipsis ? width - ellipsis_width : 0;
+  std::string res;
+  // Spaces are only added once followed by something else, tags met in between are kept
+  std::string pending;
+  std::string pending_tags;
+  size_t used = 0;
+  bool cut = false;
+  forEachCluster(text, markup, [&](size_t begin, size_t end, size_t w) {
+    auto cluster = text.substr(begin, end - begin);
+    if (w == TAG) {
+      (cut ? res : pending) += cluster;
+      pending_tags += cluster;
+      return true;
+    }
+    if (cut) {
+      return true;
+    }
+    if (used + w > budget) {
+      cut = true;
+      res += pending_tags;
+      if (show_ellipsis) {
+        res += ellipsis;
+      }
+      return true;
+    }
+    used += w;
+    auto first = begin;
+    if (g_unichar_isspace(decode(text, first))) {
+      pending += cluster;
+    } else {
+      res += pending;
+      res += cluster;
+      pending.clear();
+      pending_tags.clear();
+    }
+    return true;
+  });
+  return res;
+}
+
+}  // namespace
+
+int charWidth(char32_t c) {
+  if (c < 0x80) {
+    return 1;
+  }
+  const auto& table = widthTable();
+  auto it = std::upper_bound(table.begin(), table.end(), c,
+                             [](char32_t c, const WidthRange& range) { return c < range.first; });
+  if (it == table.begin() || (--it)->last < c) {
+    return 1;
+  }
+  return it->width;
+}
+
+size_t textWidth(std::string_view text) {
+  if (isAscii(text)) {
+    return text.size();
+  }
+  size_t width = 0;
+  for (size_t pos = 0; pos < text.size();) {
+    width += nextCluster(text, pos);
+  }
+  return width;
+}
+
+std::string truncateText(std::string_view text, size_t width, std::string_view ellipsis) {
+  return truncate(text, false, width, ellipsis);
+}
+
+std::string truncateMarkup(std::string_view markup, size_t width, std::string_view ellipsis) {
+  return truncate(markup, true, width, ellipsis);
+}
+
+}  // namespace waybar::util
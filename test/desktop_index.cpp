@@ -0,0 +1,108 @@
+#include "util/desktop_index.hpp"
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#if __has_include(<catch2/catch_test_macros.hpp>)
+#include <catch2/catch_test_macros.hpp>
+#else
+#include <catch2/catch.hpp>
+#endif
+
+#include <filesystem>
+#include <fstream>
+
+namespace fs = std::filesystem;
+using waybar::util::DesktopIndex;
+
+namespace {
+
+struct TempDirs {
+  TempDirs() {
+    root = fs::temp_directory_path() / ("waybar-test-" + std::to_string(getpid()));
+    fs::create_directories(root / "user" / "applications");
+    fs::create_directories(root / "system" / "applications" / "kde");
+  }
+  ~TempDirs() { fs::remove_all(root); }
+
+  std::vector<std::string> dataDirs() const {
+    return {(root / "user").string(), (root / "system").string()};
+  }
+  std::string cacheFile() const { return (root / "cache" / "desktop-index").string(); }
+
+  void write(const fs::path& path, const std::string& contents) const {
+    std::ofstream(root / path) << contents;
+  }
+
+  /* Make the directories look unchanged for a while, as if they were not modified recently */
+  void age() const {
+    for (const auto& dir : fs::recursive_directory_iterator(root)) {
+      if (dir.is_directory()) {
+        struct timespec times[2] = {{1000000000, 0}, {1000000000, 0}};
+        utimensat(AT_FDCWD, dir.path().c_str(), times, 0);
+      }
+    }
+  }
+
+  fs::path root;
+};
+
+}  // namespace
+
+TEST_CASE("Find desktop files by id and StartupWMClass", "[desktop_index][util]") {
+  TempDirs dirs;
+  dirs.write("system/applications/firefox.desktop",
+             "[Desktop Entry]\nName=Firefox\nIcon=firefox\n\n[Desktop Action new]\nIcon=other\n");
+  dirs.write("system/applications/org.kde.dolphin.desktop",
+             "[Desktop Entry]\nIcon = system-file-manager\nStartupWMClass=dolphin-wm\n");
+  dirs.write("system/applications/kde/konsole.desktop",
+             "[Desktop Entry]\nIcon=utilities-terminal\n");
+  dirs.write("system/applications/foot.desktop", "[Desktop Entry]\nIcon=foot\n");
+  dirs.write("user/applications/foot.desktop", "[Desktop Entry]\nIcon=/home/user/foot.svg\n");
+
+  DesktopIndex index(dirs.dataDirs(), dirs.cacheFile());
+
+  auto firefox = index.find("firefox");
+  REQUIRE(firefox.has_value());
+  REQUIRE(firefox->path == (dirs.root / "system/applications/firefox.desktop").string());
+  REQUIRE(firefox->icon == "firefox");
+  REQUIRE(index.find("org.kde.dolphin")->icon == "system-file-manager");
+  REQUIRE(index.find("dolphin")->icon == "system-file-manager");
+  REQUIRE(index.find("dolphin-wm")->icon == "system-file-manager");
+  REQUIRE(index.find("konsole")->icon == "utilities-terminal");
+  // the user data dir comes first
+  REQUIRE(index.find("foot")->icon == "/home/user/foot.svg");
+  REQUIRE_FALSE(index.find("chromium").has_value());
+  REQUIRE(fs::exists(dirs.cacheFile()));
+}
+
+TEST_CASE("Reuse the saved index until the directories change", "[desktop_index][util]") {
+  TempDirs dirs;
+  dirs.write("system/applications/firefox.desktop", "[Desktop Entry]\nIcon=firefox\n");
+  dirs.age();
+  {
+    DesktopIndex index(dirs.dataDirs(), dirs.cacheFile());
+    REQUIRE(index.find("firefox").has_value());
+  }
+
+  // Removed behind the back of the index: the saved one is still trusted
+  fs::remove(dirs.root / "system/applications/firefox.desktop");
+  dirs.age();
+  {
+    DesktopIndex index(dirs.dataDirs(), dirs.cacheFile());
+    REQUIRE(index.find("firefox").has_value());
+  }
+
+  // A new file changes the modification time of its directory
+  dirs.write("system/applications/foot.desktop", "[Desktop Entry]\nIcon=foot\n");
+  DesktopIndex index(dirs.dataDirs(), dirs.cacheFile());
+  REQUIRE(index.find("foot")->icon == "foot");
+  REQUIRE_FALSE(index.find("firefox").has_value());
+
+  // Only checked again once invalidated
+  fs::remove(dirs.root / "system/applications/foot.desktop");
+  REQUIRE(index.find("foot").has_value());
+  index.invalidate();
+  REQUIRE_FALSE(index.find("foot").has_value());
+}
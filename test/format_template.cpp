@@ -0,0 +1,50 @@
+#include "util/format_template.hpp"
+
+#if __has_include(<catch2/catch_test_macros.hpp>)
+#include <catch2/catch_test_macros.hpp>
+#else
+#include <catch2/catch.hpp>
+#endif
+
+#include "util/format.hpp"
+
+using waybar::util::FormatTemplate;
+
+TEST_CASE("FormatTemplate renders like fmt", "[format][util]") {
+  const char* formats[] = {
+      "",
+      "plain text",
+      "{}% {icon}",
+      "{percentage:>3}% {{escaped}} {used:.1f}GiB",
+      "{0} {1} {0}",
+      "{usage:{width}}",
+  };
+  for (const auto* format : formats) {
+    FormatTemplate tpl(format);
+    auto expected =
+        fmt::format(fmt::runtime(format), 42, 7, fmt::arg("icon", "X"), fmt::arg("percentage", 5),
+                    fmt::arg("used", 1.234), fmt::arg("usage", 12), fmt::arg("width", 4));
+    REQUIRE(tpl.render(42, 7, fmt::arg("icon", "X"), fmt::arg("percentage", 5),
+                       fmt::arg("used", 1.234), fmt::arg("usage", 12), fmt::arg("width", 4)) ==
+            expected);
+  }
+}
+
+TEST_CASE("FormatTemplate supports custom formatters", "[format][util]") {
+  FormatTemplate tpl("{bandwidth:>} {bandwidth}");
+  REQUIRE(tpl.render(fmt::arg("bandwidth", pow_format(2048, "B/s", true))) ==
+          fmt::format("{:>} {}", pow_format(2048, "B/s", true), pow_format(2048, "B/s", true)));
+}
+
+TEST_CASE("FormatTemplate knows the arguments it uses", "[format][util]") {
+  FormatTemplate tpl("{capacity}% {icon:>2}");
+  REQUIRE(tpl.uses("capacity"));
+  REQUIRE(tpl.uses("icon"));
+  REQUIRE_FALSE(tpl.uses("power"));
+}
+
+TEST_CASE("FormatTemplate rejects malformed formats", "[format][util]") {
+  REQUIRE_THROWS_AS(FormatTemplate("{capacity"), fmt::format_error);
+  REQUIRE_THROWS_AS(FormatTemplate("capacity}"), fmt::format_error);
+  REQUIRE_THROWS_AS(FormatTemplate("{missing}").render(fmt::arg("other", 1)), fmt::format_error);
+}
@@ -0,0 +1,122 @@
+#include "util/json.hpp"
+
+#if __has_include(<catch2/catch_test_macros.hpp>)
+#include <catch2/benchmark/catch_benchmark.hpp>
+#include <catch2/catch_test_macros.hpp>
+#else
+#define CATCH_CONFIG_ENABLE_BENCHMARKING
+#include <catch2/catch.hpp>
+#endif
+#include <memory>
+#include <string>
+
+using waybar::util::JsonParser;
+
+namespace {
+
+/* Previous implementation, a new reader per document, comments collected */
+Json::Value parseReference(const std::string& data) {
+  Json::Value root(Json::objectValue);
+  Json::CharReaderBuilder builder;
+  std::unique_ptr<Json::CharReader> const reader(builder.newCharReader());
+  std::string err;
+  if (!reader->parse(data.c_str(), data.c_str() + data.size(), &root, &err)) {
+    throw std::runtime_error(err);
+  }
+  return root;
+}
+
+/* A GET_TREE reply of sway with `windows` windows on each of 10 workspaces of 2 outputs */
+std::string makeTree(int windows) {
+  int id = 1;
+  Json::Value root;
+  root["id"] = id++;
+  root["type"] = "root";
+  root["name"] = "root";
+  for (int o = 0; o < 2; ++o) {
+    Json::Value output;
+    output["id"] = id++;
+    output["type"] = "output";
+    output["name"] = "DP-" + std::to_string(o);
+    output["current_workspace"] = std::to_string(o * 10 + 1);
+    for (int w = 0; w < 10; ++w) {
+      Json::Value workspace;
+      workspace["id"] = id++;
+      workspace["type"] = "workspace";
+      workspace["name"] = std::to_string(o * 10 + w + 1);
+      workspace["num"] = o * 10 + w + 1;
+      workspace["layout"] = "splith";
+      workspace["floating_nodes"] = Json::Value(Json::arrayValue);
+      for (int c = 0; c < windows; ++c) {
+        Json::Value con;
+        con["id"] = id++;
+        con["type"] = "con";
+        con["name"] = "Some window title - " + std::to_string(id);
+        con["app_id"] = "org.example.app" + std::to_string(c);
+        con["shell"] = "xdg_shell";
+        con["focused"] = false;
+        con["urgent"] = false;
+        con["marks"] = Json::Value(Json::arrayValue);
+        for (const auto* rect : {"rect", "window_rect", "deco_rect", "geometry"}) {
+          con[rect]["x"] = 1920 * o;
+          con[rect]["y"] = 0;
+          con[rect]["width"] = 1920 / windows;
+          con[rect]["height"] = 1080;
+        }
+        con["nodes"] = Json::Value(Json::arrayValue);
+        con["floating_nodes"] = Json::Value(Json::arrayValue);
+        workspace["nodes"].append(con);
+      }
+      output["nodes"].append(workspace);
+    }
+    root["nodes"].append(output);
+  }
+  Json::StreamWriterBuilder writer;
+  return Json::writeString(writer, root);
+}
+
+}  // namespace
+
+TEST_CASE("Parse JSON documents", "[json][util]") {
+  JsonParser parser;
+  REQUIRE(parser.parse("").isObject());
+  REQUIRE(parser.parse(std::string_view("[1, 2]")).size() == 2);
+  // the reader is reused, including after an error
+  REQUIRE_THROWS(parser.parse("{\"a\": "));
+  auto config = parser.parse("// comment\n{\"height\": 30 /* px */}");
+  REQUIRE(config["height"].asInt() == 30);
+
+  auto tree = makeTree(8);
+  REQUIRE(parser.parse(tree) == parseReference(tree));
+}
+
+TEST_CASE("Leave members out of JSON documents", "[json][util]") {
+  JsonParser parser({"rect", "marks"});
+  REQUIRE(parser.parse(R"({"rect": {"x": [1, {"y": "}"}]}, "id": 1})") ==
+          parseReference(R"({"id": 1})"));
+  REQUIRE(parser.parse(R"({"id": 1, "marks": ["a,b"]})") == parseReference(R"({"id": 1})"));
+  REQUIRE(parser.parse("{\n  \"id\": 1,\n  \"marks\": 2\n}") == parseReference(R"({"id": 1})"));
+  REQUIRE(parser.parse(R"({"marks": null})") == parseReference("{}"));
+  // only members are left out, not strings nor members of other names
+  REQUIRE(parser.parse(R"(["rect", {"name": "rect", "rects": 1}])") ==
+          parseReference(R"(["rect", {"name": "rect", "rects": 1}])"));
+  REQUIRE(parser.parse(R"({"a\"rect": 1})")["a\"rect"] == 1);
+
+  JsonParser tree_parser({"rect", "window_rect", "deco_rect", "geometry", "marks"});
+  auto tree = tree_parser.parse(makeTree(8));
+  const auto& con = tree["nodes"][1]["nodes"][2]["nodes"][3];
+  REQUIRE(con["app_id"] == "org.example.app3");
+  REQUIRE_FALSE(con.isMember("rect"));
+  REQUIRE_FALSE(con.isMember("marks"));
+}
+
+TEST_CASE("JSON parser benchmark", "[.][benchmark][json]") {
+  JsonParser parser;
+  auto tree = makeTree(25);
+  BENCHMARK("GET_TREE, " + std::to_string(tree.size() / 1024) + "KB") {
+    return parser.parse(tree);
+  };
+  BENCHMARK("GET_TREE, previous implementation") { return parseReference(tree); };
+  JsonParser tree_parser({"rect", "window_rect", "deco_rect", "geometry", "marks"});
+  BENCHMARK("GET_TREE, geometry left out") { return tree_parser.parse(tree); };
+}
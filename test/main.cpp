@@ -7,6 +7,8 @@
 #include <catch2/catch_all.hpp>
 #include <catch2/reporters/catch_reporter_tap.hpp>
 #else
+// Benchmarks are always available with Catch2 3
+#define CATCH_CONFIG_ENABLE_BENCHMARKING
 #include <catch2/catch.hpp>
 #include <catch2/catch_reporter_tap.hpp>
 #endif
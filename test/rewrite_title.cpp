@@ -0,0 +1,71 @@
+#include "util/rewrite_title.hpp"
+
+#if __has_include(<catch2/catch_test_macros.hpp>)
+#include <catch2/catch_test_macros.hpp>
+#else
+#include <catch2/catch.hpp>
+#endif
+#include <regex>
+#include <string>
+
+using waybar::util::LruCache;
+using waybar::util::RewriteRules;
+
+namespace {
+
+/* Rules applied without compiling or filtering anything */
+std::string rewriteReference(const std::string& title, const Json::Value& rules) {
+  std::string res = title;
+  for (auto it = rules.begin(); it != rules.end(); ++it) {
+    const std::regex rule{it.key().asString()};
+    if (std::regex_match(title, rule)) {
+      res = std::regex_replace(res, rule, it->asString());
+    }
+  }
+  return res;
+}
+
+}  // namespace
+
+TEST_CASE("RewriteRules matches the uncompiled rules", "[rewrite][util]") {
+  Json::Value rules;
+  rules["(.*) - Mozilla Firefox"] = "🌎 $1";
+  rules["^Term: (.*)"] = "> $1";
+  rules["ab*c(.*)"] = "abc$1";
+  rules["x+yz"] = "xyz";
+  rules["file\\.txt \\((\\d+)\\)"] = "file #$1";
+  rules["one|two"] = "number";
+  RewriteRules compiled(rules);
+
+  for (const std::string title :
+       {"Waybar - Mozilla Firefox", "Term: vim", "Term:", "ac", "abbbc tail", "bc", "xxyz", "yz",
+        "file.txt (12)", "fileatxt (12)", "one", "two", "three", ""}) {
+    CAPTURE(title);
+    REQUIRE(compiled.apply(title) == rewriteReference(title, rules));
+    // Second time from the cache
+    REQUIRE(compiled.apply(title) == rewriteReference(title, rules));
+  }
+}
+
+TEST_CASE("RewriteRules ignores invalid rules", "[rewrite][util]") {
+  Json::Value rules;
+  rules["(unclosed"] = "never";
+  rules["(.*) - vim"] = "$1";
+  RewriteRules compiled(rules);
+  REQUIRE(compiled.apply("main.cpp - vim") == "main.cpp");
+  REQUIRE(RewriteRules(Json::Value()).apply("title") == "title");
+}
+
+TEST_CASE("LruCache evicts the least recently used entry", "[lru][util]") {
+  LruCache<int, int> cache(2);
+  cache.put(1, 10);
+  cache.put(2, 20);
+  REQUIRE(*cache.get(1) == 10);
+  cache.put(3, 30);
+  REQUIRE(cache.size() == 2);
+  REQUIRE(cache.get(2) == nullptr);
+  REQUIRE(*cache.get(1) == 10);
+  REQUIRE(*cache.get(3) == 30);
+  cache.put(1, 11);
+  REQUIRE(*cache.get(1) == 11);
+}
@@ -0,0 +1,35 @@
+#include "util/ring_buffer.hpp"
+
+#if __has_include(<catch2/catch_test_macros.hpp>)
+#include <catch2/catch_test_macros.hpp>
+#else
+#include <catch2/catch.hpp>
+#endif
+#include <vector>
+
+using waybar::util::RingBuffer;
+
+TEST_CASE("RingBuffer keeps the latest samples in order", "[ring_buffer][util]") {
+  RingBuffer<int> buffer(3);
+  REQUIRE(buffer.size() == 0);
+
+  for (int i = 1; i <= 5; ++i) {
+    buffer.push(std::vector<int>{i, i * 10});
+  }
+  REQUIRE(buffer.series() == 2);
+  REQUIRE(buffer.size() == 3);
+  REQUIRE(buffer.at(0, 0) == 3);
+  REQUIRE(buffer.at(0, 2) == 5);
+  REQUIRE(buffer.at(1, 1) == 40);
+  REQUIRE(buffer.back(1) == 50);
+}
+
+TEST_CASE("RingBuffer restarts when the series count changes", "[ring_buffer][util]") {
+  RingBuffer<int> buffer(4);
+  buffer.push(std::vector<int>{1, 2});
+  buffer.push(std::vector<int>{3, 4});
+  buffer.push(std::vector<int>{5, 6, 7});
+  REQUIRE(buffer.series() == 3);
+  REQUIRE(buffer.size() == 1);
+  REQUIRE(buffer.back(2) == 7);
+}
@@ -0,0 +1,70 @@
+#include "util/sanitize_str.hpp"
+
+#if __has_include(<catch2/catch_test_macros.hpp>)
+#include <catch2/benchmark/catch_benchmark.hpp>
+#include <catch2/catch_test_macros.hpp>
+#else
+#define CATCH_CONFIG_ENABLE_BENCHMARKING
+#include <catch2/catch.hpp>
+#endif
+#include <string>
+#include <utility>
+
+using waybar::util::sanitize_string;
+
+namespace {
+
+/* Previous implementation, one find/replace pass per character */
+std::string sanitizeReference(std::string str) {
+  const std::pair<char, std::string> replacement_table[] = {
+      {'&', "&amp;"}, {'<', "&lt;"}, {'>', "&gt;"}, {'"', "&quot;"}, {'\'', "&apos;"}};
+  for (const auto& [c, replacement] : replacement_table) {
+    size_t startpoint = 0;
+    while ((startpoint = str.find(c, startpoint)) != std::string::npos) {
+      str.replace(startpoint, 1, replacement);
+      startpoint += replacement.length();
+    }
+  }
+  return str;
+}
+
+/* Long title, one character in `every` needs to be escaped */
+std::string makeTitle(size_t length, size_t every) {
+  const std::string special = "&<>\"'";
+  std::string title;
+  for (size_t i = 0; i < length; ++i) {
+    title += (i + 1) % every == 0 ? special[i / every % special.size()]
+                                   : static_cast<char>('a' + i % 26);
+  }
+  return title;
+}
+
+}  // namespace
+
+TEST_CASE("sanitize_string escapes markup characters", "[sanitize][util]") {
+  REQUIRE(sanitize_string("") == "");
+  REQUIRE(sanitize_string("plain title") == "plain title");
+  REQUIRE(sanitize_string("<b>Tom & Jerry's \"show\"</b>") ==
+          "&lt;b&gt;Tom &amp; Jerry&apos;s &quot;show&quot;&lt;/b&gt;");
+  REQUIRE(sanitize_string("&amp;") == "&amp;amp;");
+  REQUIRE(sanitize_string("ü & ö") == "ü &amp; ö");
+  REQUIRE(sanitize_string(std::string("a\0<", 3)) == std::string("a\0&lt;", 6));
+  for (size_t every : {1, 2, 7, 1000}) {
+    auto title = makeTitle(500, every);
+    REQUIRE(sanitize_string(title) == sanitizeReference(title));
+  }
+}
+
+TEST_CASE("sanitize_string benchmark", "[.][benchmark][sanitize]") {
+  auto plain = makeTitle(1024, 2048);
+  auto sparse = makeTitle(1024, 20);
+  auto dense = makeTitle(1024, 3);
+  BENCHMARK("plain title") { return sanitize_string(plain); };
+  BENCHMARK("plain title, previous implementation") { return sanitizeReference(plain); };
+  BENCHMARK("sparsely escaped title") { return sanitize_string(sparse); };
+  BENCHMARK("sparsely escaped title, previous implementation") {
+    return sanitizeReference(sparse);
+  };
+  BENCHMARK("escaped title") { return sanitize_string(dense); };
+  BENCHMARK("escaped title, previous implementation") { return sanitizeReference(dense); };
+}
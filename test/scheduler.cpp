@@ -0,0 +1,108 @@
+#include "util/scheduler.hpp"
+
+#if __has_include(<catch2/catch_test_macros.hpp>)
+#include <catch2/catch_test_macros.hpp>
+#else
+#include <catch2/catch.hpp>
+#endif
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+
+using namespace waybar::util;
+using namespace std::chrono_literals;
+
+namespace {
+
+/* Counts timer invocations and lets the test wait for a given number of them */
+struct Counter {
+  std::mutex mutex;
+  std::condition_variable cv;
+  int count = 0;
+
+  void hit() {
+    std::lock_guard<std::mutex> lock(mutex);
+    ++count;
+    cv.notify_all();
+  }
+
+  bool waitFor(int n, std::chrono::milliseconds timeout = 500ms) {
+    std::unique_lock lock(mutex);
+    return cv.wait_for(lock, timeout, [&] { return count >= n; });
+  }
+};
+
+}  // namespace
+
+TEST_CASE("Scheduler runs periodic callbacks", "[scheduler][thread][util]") {
+  Counter counter;
+  Timer timer;
+  timer.start(10ms, [&] { counter.hit(); });
+  REQUIRE(timer.isRunning());
+  // first invocation is immediate, then one per interval
+  REQUIRE(counter.waitFor(3));
+  timer.stop();
+  REQUIRE_FALSE(timer.isRunning());
+}
+
+TEST_CASE("Scheduler wake_up triggers an early run", "[scheduler][thread][util]") {
+  Counter counter;
+  Timer timer;
+  timer.start(1h, [&] { counter.hit(); });
+  REQUIRE(counter.waitFor(1));
+  timer.wake_up();
+  REQUIRE(counter.waitFor(2));
+}
+
+TEST_CASE("Scheduler wake_up with a delay", "[scheduler][thread][util]") {
+  Counter counter;
+  Timer timer;
+  std::chrono::steady_clock::time_point first;
+  std::atomic<bool> delayed = false;
+  timer.start(1h, [&] {
+    // Only the scheduler thread touches `first`
+    if (first == std::chrono::steady_clock::time_point()) {
+      first = std::chrono::steady_clock::now();
+      // From the callback itself, as the Sampler does after its warm-up
+      timer.wake_up(50ms);
+    } else {
+      delayed = std::chrono::steady_clock::now() - first >= 50ms;
+    }
+    counter.hit();
+  });
+  REQUIRE(counter.waitFor(2));
+  REQUIRE(delayed);
+  REQUIRE_FALSE(counter.waitFor(3, 100ms));
+}
+
+TEST_CASE("Scheduler shares one thread between timers", "[scheduler][thread][util]") {
+  Counter a, b;
+  std::atomic<std::thread::id> tid_a, tid_b;
+  Timer timer_a, timer_b;
+  timer_a.start(5ms, [&] {
+    tid_a = std::this_thread::get_id();
+    a.hit();
+  });
+  timer_b.start(7ms, [&] {
+    tid_b = std::this_thread::get_id();
+    b.hit();
+  });
+  REQUIRE(a.waitFor(2));
+  REQUIRE(b.waitFor(2));
+  REQUIRE(tid_a.load() == tid_b.load());
+  REQUIRE(tid_a.load() != std::this_thread::get_id());
+}
+
+TEST_CASE("Scheduler callback can stop its own timer", "[scheduler][thread][util]") {
+  Counter counter;
+  Timer timer;
+  timer.start(1ms, [&] {
+    timer.stop();
+    counter.hit();
+  });
+  REQUIRE(counter.waitFor(1));
+  std::this_thread::sleep_for(20ms);
+  std::lock_guard<std::mutex> lock(counter.mutex);
+  REQUIRE(counter.count == 1);
+}
@@ -0,0 +1,42 @@
+#include "util/text_width.hpp"
+
+#if __has_include(<catch2/catch_test_macros.hpp>)
+#include <catch2/catch_test_macros.hpp>
+#else
+#include <catch2/catch.hpp>
+#endif
+
+using waybar::util::textWidth;
+using waybar::util::truncateMarkup;
+using waybar::util::truncateText;
+
+TEST_CASE("textWidth counts columns", "[text_width][util]") {
+  REQUIRE(textWidth("") == 0);
+  REQUIRE(textWidth("waybar") == 6);
+  REQUIRE(textWidth("日本語") == 6);
+  // e + combining acute accent
+  REQUIRE(textWidth("é") == 1);
+  // thumbs up with a skin tone modifier
+  REQUIRE(textWidth("\U0001F44D\U0001F3FD") == 2);
+  // invalid UTF-8 counts one column per byte
+  REQUIRE(textWidth("a\xff\xfe") == 3);
+}
+
+TEST_CASE("truncateText keeps whole clusters", "[text_width][util]") {
+  REQUIRE(truncateText("short", 10) == "short");
+  REQUIRE(truncateText("hello world", 8) == "hello w…");
+  // no space left before the ellipsis
+  REQUIRE(truncateText("hello world", 7) == "hello…");
+  REQUIRE(truncateText("日本語のテキスト", 7) == "日本語…");
+  REQUIRE(truncateText("ééé", 2) == "é…");
+  REQUIRE(truncateText("abcdef", 4, "...") == "a...");
+  REQUIRE(truncateText("abcdef", 2, "...") == "");
+  REQUIRE(truncateText("abcdef", 0) == "");
+}
+
+TEST_CASE("truncateMarkup keeps the tags", "[text_width][util]") {
+  REQUIRE(truncateMarkup("<b>bold</b>", 4) == "<b>bold</b>");
+  REQUIRE(truncateMarkup("<b>bold</b> and <i>italic</i>", 12) == "<b>bold</b> and <i>it…</i>");
+  REQUIRE(truncateMarkup("x &lt; y &amp; z", 6) == "x &lt; y…");
+  REQUIRE(truncateMarkup("<span color='red'>x &lt; y</span>", 3) == "<span color='red'>x…</span>");
+}